@@ -0,0 +1,124 @@
+#include "Mcp/UEMCPServerAdmissionControl.h"
+#include "Mcp/UEMCPServerMcpSettings.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+
+bool FUEMCPServerTokenBucket::TryConsume(double Rate, double Burst, double Cost, double Now, double& OutRetryAfterSeconds)
+{
+	// A request larger than the bucket could never pass; charge it a full bucket instead.
+	Cost = FMath::Min(Cost, Burst);
+
+	if (LastRefillSeconds < 0.0)
+	{
+		Tokens = Burst;
+	}
+	else
+	{
+		Tokens = FMath::Min(Burst, Tokens + (Now - LastRefillSeconds) * Rate);
+	}
+	LastRefillSeconds = Now;
+
+	if (Tokens >= Cost)
+	{
+		Tokens -= Cost;
+		return true;
+	}
+
+	OutRetryAfterSeconds = (Cost - Tokens) / Rate;
+	return false;
+}
+
+FUEMCPServerAdmissionControl::FUEMCPServerAdmissionControl(const FUEMCPServerMcpServerSettings& Settings)
+	: SessionRate(Settings.SessionRequestsPerSecond)
+	, SessionBurst(FMath::Max(Settings.SessionRequestBurst, 1.0))
+	, GlobalRate(Settings.GlobalRequestsPerSecond)
+	, GlobalBurst(FMath::Max(Settings.GlobalRequestBurst, 1.0))
+	, MaxInFlight(Settings.MaxInFlightRequests)
+	, InFlight(0)
+{
+}
+
+EUEMCPServerAdmission FUEMCPServerAdmissionControl::TryAdmit(const FGuid& SessionId, double& OutRetryAfterSeconds)
+{
+	OutRetryAfterSeconds = 1.0;
+
+	const int32 NewInFlight = ++InFlight;
+	if (MaxInFlight > 0 && NewInFlight > MaxInFlight)
+	{
+		--InFlight;
+		FScopeLock Guard(&BucketMutex);
+		++Metrics.RejectedInFlight;
+		return EUEMCPServerAdmission::TooManyInFlight;
+	}
+
+	FScopeLock Guard(&BucketMutex);
+	const EUEMCPServerAdmission Admission = ConsumeLocked(SessionId, 1.0, OutRetryAfterSeconds);
+	if (Admission != EUEMCPServerAdmission::Admitted)
+	{
+		--InFlight;
+		return Admission;
+	}
+
+	++Metrics.Admitted;
+	return Admission;
+}
+
+EUEMCPServerAdmission FUEMCPServerAdmissionControl::TryChargeMessages(const FGuid& SessionId, int32 MessageCount, double& OutRetryAfterSeconds)
+{
+	// Each message of a batch costs a token, so batching does not bypass the limit; TryAdmit took the first.
+	if (MessageCount <= 1)
+	{
+		return EUEMCPServerAdmission::Admitted;
+	}
+
+	FScopeLock Guard(&BucketMutex);
+	return ConsumeLocked(SessionId, MessageCount - 1, OutRetryAfterSeconds);
+}
+
+EUEMCPServerAdmission FUEMCPServerAdmissionControl::ConsumeLocked(const FGuid& SessionId, double Cost, double& OutRetryAfterSeconds)
+{
+	const double Now = FPlatformTime::Seconds();
+	const bool bChargeSession = SessionRate > 0.0 && SessionId.IsValid();
+
+	// Check both buckets before taking from either, so a rejected request costs nothing.
+	FUEMCPServerTokenBucket SessionProbe = bChargeSession ? SessionBuckets.FindRef(SessionId) : FUEMCPServerTokenBucket();
+	FUEMCPServerTokenBucket GlobalProbe = GlobalBucket;
+	if (bChargeSession && !SessionProbe.TryConsume(SessionRate, SessionBurst, Cost, Now, OutRetryAfterSeconds))
+	{
+		++Metrics.RejectedSessionRate;
+		return EUEMCPServerAdmission::SessionRateLimited;
+	}
+
+	if (GlobalRate > 0.0 && !GlobalProbe.TryConsume(GlobalRate, GlobalBurst, Cost, Now, OutRetryAfterSeconds))
+	{
+		++Metrics.RejectedGlobalRate;
+		return EUEMCPServerAdmission::GlobalRateLimited;
+	}
+
+	if (bChargeSession)
+	{
+		SessionBuckets.Add(SessionId, SessionProbe);
+	}
+	GlobalBucket = GlobalProbe;
+	return EUEMCPServerAdmission::Admitted;
+}
+
+void FUEMCPServerAdmissionControl::Release()
+{
+	--InFlight;
+}
+
+void FUEMCPServerAdmissionControl::ForgetSession(const FGuid& SessionId)
+{
+	FScopeLock Guard(&BucketMutex);
+	SessionBuckets.Remove(SessionId);
+}
+
+FUEMCPServerAdmissionMetrics FUEMCPServerAdmissionControl::GetMetrics() const
+{
+	FScopeLock Guard(&BucketMutex);
+	FUEMCPServerAdmissionMetrics Result = Metrics;
+	Result.InFlight = InFlight.Load();
+	return Result;
+}
@@ -1,20 +1,46 @@
 #include "Mcp/UEMCPServerHttpUtils.h"
+#include "Mcp/UEMCPServerMcpMessage.h"
 
-#include "Containers/StringConv.h"
 #include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Misc/CString.h"
+#include "Misc/Crc.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
 
-FString UEMCPServerHttpUtils::RequestBodyToString(const FHttpServerRequest& Request)
+FUEMCPServerRequestHeaders::FUEMCPServerRequestHeaders(const TMap<FString, TArray<FString>>& RawHeaders)
 {
-	if (Request.Body.IsEmpty())
+	Values.Reserve(RawHeaders.Num());
+	for (const TPair<FString, TArray<FString>>& Pair : RawHeaders)
 	{
-		return FString();
+		const FString* FirstValue = Pair.Value.FindByPredicate([](const FString& Value) { return !Value.IsEmpty(); });
+		if (!FirstValue)
+		{
+			continue;
+		}
+
+		// Header names are case-insensitive; the first spelling that carries a value wins.
+		FString Name = Pair.Key.ToLower();
+		if (!Values.Contains(Name))
+		{
+			Values.Add(MoveTemp(Name), *FirstValue);
+		}
 	}
 
-	const ANSICHAR* Utf8Data = reinterpret_cast<const ANSICHAR*>(Request.Body.GetData());
-	FUTF8ToTCHAR Converter(Utf8Data, Request.Body.Num());
-	return FString(Converter.Length(), Converter.Get());
+	Accept = Find(TEXTVIEW("accept"));
+	ProtocolVersion = Find(TEXTVIEW("mcp-protocol-version"));
+	SessionId = Find(TEXTVIEW("mcp-session-id"));
+	LastEventId = Find(TEXTVIEW("last-event-id"));
+	AcceptEncoding = Find(TEXTVIEW("accept-encoding"));
+}
+
+const FString& FUEMCPServerRequestHeaders::Find(FStringView Name) const
+{
+	static const FString Empty;
+	// FString keys hash and compare case-insensitively, and a view hashes like the equal FString, so the lookup
+	// needs neither a lowercased nor a temporary key.
+	const FString* Value = Values.FindByHash(GetTypeHash(Name), Name);
+	return Value ? *Value : Empty;
 }
 
 FString UEMCPServerHttpUtils::PeerEndpointString(const TSharedPtr<FInternetAddr>& PeerAddress)
@@ -22,71 +48,297 @@ FString UEMCPServerHttpUtils::PeerEndpointString(const TSharedPtr<FInternetAddr>
 	return PeerAddress.IsValid() ? PeerAddress->ToString(true) : FString(TEXT("unknown"));
 }
 
-bool UEMCPServerHttpUtils::ContainsToken(const FString& Source, const FString& Token)
+namespace
 {
-	TArray<FString> Parts;
-	Source.ParseIntoArray(Parts, TEXT(","), true);
-	for (FString& Part : Parts)
+	/** How closely a media range matches a media type; a more specific range overrides a less specific one. */
+	enum class EMediaRangeMatch : uint8
 	{
-		Part.TrimStartAndEndInline();
-		FString TokenPart;
-		FString Remainder;
-		if (Part.Split(TEXT(";"), &TokenPart, &Remainder))
+		None,
+		Wildcard,
+		TypeWildcard,
+		Exact,
+	};
+
+	struct FMediaTypeQuality
+	{
+		EMediaRangeMatch Match = EMediaRangeMatch::None;
+		uint16 Quality = 0;
+
+		void Offer(EMediaRangeMatch RangeMatch, uint16 RangeQuality)
 		{
-			TokenPart.TrimEndInline();
+			if (RangeMatch > Match)
+			{
+				Match = RangeMatch;
+				Quality = RangeQuality;
+			}
 		}
-		else
+	};
+
+	EMediaRangeMatch MatchMediaRange(FStringView Range, FStringView Type, FStringView SubType)
+	{
+		if (Range == TEXT("*") || Range == TEXT("*/*"))
 		{
-			TokenPart = Part;
+			return EMediaRangeMatch::Wildcard;
 		}
 
-		if (TokenPart.Equals(Token, ESearchCase::IgnoreCase))
+		int32 SlashIndex = INDEX_NONE;
+		if (!Range.FindChar(TEXT('/'), SlashIndex))
 		{
-			return true;
+			return EMediaRangeMatch::None;
 		}
 
-		if (TokenPart.Equals(TEXT("*/*"), ESearchCase::IgnoreCase))
+		const FStringView RangeType = Range.Left(SlashIndex);
+		const FStringView RangeSubType = Range.Mid(SlashIndex + 1);
+		if (!RangeType.Equals(Type, ESearchCase::IgnoreCase))
 		{
-			return true;
+			return EMediaRangeMatch::None;
+		}
+		if (RangeSubType == TEXT("*"))
+		{
+			return EMediaRangeMatch::TypeWildcard;
 		}
+		return RangeSubType.Equals(SubType, ESearchCase::IgnoreCase) ? EMediaRangeMatch::Exact : EMediaRangeMatch::None;
+	}
+
+	FUEMCPServerAcceptPreferences ParseAccept(FStringView Accept)
+	{
+		FMediaTypeQuality Json;
+		FMediaTypeQuality EventStream;
 
-		int32 SlashIndexCandidate = INDEX_NONE;
-		int32 SlashIndexTarget = INDEX_NONE;
-		if (TokenPart.FindChar(TEXT('/'), SlashIndexCandidate) && Token.FindChar(TEXT('/'), SlashIndexTarget))
+		FStringView MediaRange;
+		uint16 Quality = 0;
+		while (UEMCPServerHttpUtils::NextListElement(Accept, MediaRange, Quality))
 		{
-			const FString CandidateType = TokenPart.Left(SlashIndexCandidate);
-			const FString CandidateSubType = TokenPart.Mid(SlashIndexCandidate + 1);
-			const FString TargetType = Token.Left(SlashIndexTarget);
-			const FString TargetSubType = Token.Mid(SlashIndexTarget + 1);
+			Json.Offer(MatchMediaRange(MediaRange, TEXTVIEW("application"), TEXTVIEW("json")), Quality);
+			EventStream.Offer(MatchMediaRange(MediaRange, TEXTVIEW("text"), TEXTVIEW("event-stream")), Quality);
+		}
 
-			if (CandidateType.Equals(TargetType, ESearchCase::IgnoreCase) && CandidateSubType.Equals(TEXT("*"), ESearchCase::IgnoreCase))
+		FUEMCPServerAcceptPreferences Preferences;
+		Preferences.JsonQuality = Json.Quality;
+		Preferences.EventStreamQuality = EventStream.Quality;
+		return Preferences;
+	}
+
+	/**
+	 * Direct-mapped cache of negotiated Accept headers. Each slot packs the header's hash and length with both
+	 * qualities into one atomic word, so lookups and updates take no lock; a slot losing a race is simply re-parsed.
+	 */
+	struct FAcceptCache
+	{
+		static constexpr int32 NumSlots = 64;
+		static constexpr uint64 ValidBit = 1;
+
+		TAtomic<uint64> Slots[NumSlots];
+
+		FAcceptCache()
+		{
+			for (TAtomic<uint64>& Slot : Slots)
 			{
-				return true;
+				Slot = 0;
 			}
+		}
 
-			if (CandidateType.Equals(TEXT("*"), ESearchCase::IgnoreCase) && CandidateSubType.Equals(TargetSubType, ESearchCase::IgnoreCase))
+		static uint64 MakeKey(uint32 Hash, int32 Length)
+		{
+			return (static_cast<uint64>(Hash) << 32) | (static_cast<uint64>(Length & 0x7FF) << 21);
+		}
+
+		static constexpr uint64 KeyMask = ~((uint64(1) << 21) - 1);
+
+		bool Find(uint32 Hash, int32 Length, FUEMCPServerAcceptPreferences& OutPreferences) const
+		{
+			const uint64 Entry = Slots[Hash % NumSlots].Load(EMemoryOrder::Relaxed);
+			if ((Entry & ValidBit) == 0 || (Entry & KeyMask) != MakeKey(Hash, Length))
 			{
-				return true;
+				return false;
 			}
+			OutPreferences.JsonQuality = static_cast<uint16>((Entry >> 11) & 0x3FF);
+			OutPreferences.EventStreamQuality = static_cast<uint16>((Entry >> 1) & 0x3FF);
+			return true;
 		}
 
-		if (TokenPart.Equals(TEXT("*"), ESearchCase::IgnoreCase))
+		void Store(uint32 Hash, int32 Length, const FUEMCPServerAcceptPreferences& Preferences)
 		{
-			return true;
+			const uint64 Entry = MakeKey(Hash, Length)
+				| (static_cast<uint64>(Preferences.JsonQuality & 0x3FF) << 11)
+				| (static_cast<uint64>(Preferences.EventStreamQuality & 0x3FF) << 1)
+				| ValidBit;
+			Slots[Hash % NumSlots].Store(Entry, EMemoryOrder::Relaxed);
+		}
+	};
+}
+
+uint16 UEMCPServerHttpUtils::ParseQuality(FStringView Value)
+{
+	if (Value.IsEmpty() || (Value[0] != TEXT('0') && Value[0] != TEXT('1')))
+	{
+		return 1000;
+	}
+
+	int32 Quality = (Value[0] - TEXT('0')) * 1000;
+	if (Value.Len() > 1)
+	{
+		if (Value[1] != TEXT('.') || Value.Len() > 5)
+		{
+			return 1000;
+		}
+		int32 Scale = 100;
+		for (int32 Index = 2; Index < Value.Len(); ++Index, Scale /= 10)
+		{
+			if (!FChar::IsDigit(Value[Index]))
+			{
+				return 1000;
+			}
+			Quality += (Value[Index] - TEXT('0')) * Scale;
 		}
 	}
+	return static_cast<uint16>(FMath::Min(Quality, 1000));
+}
+
+bool UEMCPServerHttpUtils::NextListElement(FStringView& List, FStringView& OutToken, uint16& OutQuality)
+{
+	while (!List.IsEmpty())
+	{
+		int32 CommaIndex = INDEX_NONE;
+		FStringView Element = List;
+		if (List.FindChar(TEXT(','), CommaIndex))
+		{
+			Element = List.Left(CommaIndex);
+			List.RightChopInline(CommaIndex + 1);
+		}
+		else
+		{
+			List = FStringView();
+		}
+
+		int32 SemicolonIndex = INDEX_NONE;
+		FStringView Parameters;
+		if (Element.FindChar(TEXT(';'), SemicolonIndex))
+		{
+			Parameters = Element.Mid(SemicolonIndex + 1);
+			Element.LeftInline(SemicolonIndex);
+		}
+		Element.TrimStartAndEndInline();
+		if (Element.IsEmpty())
+		{
+			continue;
+		}
+
+		OutToken = Element;
+		OutQuality = 1000;
+		while (!Parameters.IsEmpty())
+		{
+			int32 NextIndex = INDEX_NONE;
+			FStringView Parameter = Parameters;
+			if (Parameters.FindChar(TEXT(';'), NextIndex))
+			{
+				Parameter = Parameters.Left(NextIndex);
+				Parameters.RightChopInline(NextIndex + 1);
+			}
+			else
+			{
+				Parameters = FStringView();
+			}
+
+			Parameter.TrimStartAndEndInline();
+			if (Parameter.Len() >= 2 && (Parameter[0] == TEXT('q') || Parameter[0] == TEXT('Q')) && Parameter[1] == TEXT('='))
+			{
+				OutQuality = ParseQuality(Parameter.Mid(2).TrimStartAndEnd());
+			}
+		}
+		return true;
+	}
 	return false;
 }
 
-TSharedPtr<FJsonObject> UEMCPServerHttpUtils::ParseJsonObject(const FString& Body)
+FUEMCPServerAcceptPreferences UEMCPServerHttpUtils::NegotiateAccept(FStringView Accept)
+{
+	if (Accept.IsEmpty())
+	{
+		// No Accept header means anything goes; answer with plain JSON as before.
+		FUEMCPServerAcceptPreferences Preferences;
+		Preferences.JsonQuality = 1000;
+		return Preferences;
+	}
+
+	static FAcceptCache Cache;
+	const uint32 Hash = FCrc::MemCrc32(Accept.GetData(), Accept.Len() * sizeof(TCHAR));
+
+	FUEMCPServerAcceptPreferences Preferences;
+	if (!Cache.Find(Hash, Accept.Len(), Preferences))
+	{
+		Preferences = ParseAccept(Accept);
+		Cache.Store(Hash, Accept.Len(), Preferences);
+	}
+	return Preferences;
+}
+
+namespace
+{
+	FUEMCPServerMcpMessage DecodeMcpMessage(const TSharedPtr<FJsonValue>& Value)
+	{
+		FUEMCPServerMcpMessage Message;
+		const TSharedPtr<FJsonObject>* Object = nullptr;
+		if (!Value.IsValid() || !Value->TryGetObject(Object) || !Object || !Object->IsValid())
+		{
+			return Message;
+		}
+
+		Message.Object = *Object;
+		Message.Id = Message.Object->TryGetField(TEXT("id"));
+
+		FString JsonRpcVersion;
+		Message.bIsJsonRpc20 = Message.Object->TryGetStringField(TEXT("jsonrpc"), JsonRpcVersion) && JsonRpcVersion == TEXT("2.0");
+		Message.Object->TryGetStringField(TEXT("method"), Message.Method);
+
+		const TSharedPtr<FJsonObject>* ParamsObject = nullptr;
+		if (Message.Object->TryGetObjectField(TEXT("params"), ParamsObject) && ParamsObject)
+		{
+			Message.Params = *ParamsObject;
+		}
+		return Message;
+	}
+}
+
+bool UEMCPServerHttpUtils::ParseMcpPayload(const TArray<uint8>& Utf8Body, FUEMCPServerMcpPayload& OutPayload)
 {
-	TSharedPtr<FJsonObject> Object;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Body);
-	if (FJsonSerializer::Deserialize(Reader, Object) && Object.IsValid())
+	OutPayload = FUEMCPServerMcpPayload();
+
+	// Decode straight from the UTF-8 request bytes; the body is never widened to TCHAR.
+	const FUtf8StringView BodyView(reinterpret_cast<const UTF8CHAR*>(Utf8Body.GetData()), Utf8Body.Num());
+	TSharedPtr<FJsonValue> Root;
+	TSharedRef<TJsonReader<UTF8CHAR>> Reader = TJsonReaderFactory<UTF8CHAR>::CreateFromView(BodyView);
+	if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+	{
+		return false;
+	}
+
+	if (Root->Type == EJson::Object)
+	{
+		OutPayload.Messages.Add(DecodeMcpMessage(Root));
+		return true;
+	}
+
+	if (Root->Type != EJson::Array)
+	{
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>& Batch = Root->AsArray();
+	if (Batch.IsEmpty())
+	{
+		// JSON-RPC answers an empty batch with a single Invalid Request error, not an array.
+		OutPayload.Messages.AddDefaulted();
+		return true;
+	}
+
+	OutPayload.bIsBatch = true;
+	OutPayload.Messages.Reserve(Batch.Num());
+	for (const TSharedPtr<FJsonValue>& Element : Batch)
 	{
-		return Object;
+		OutPayload.Messages.Add(DecodeMcpMessage(Element));
 	}
-	return nullptr;
+	return true;
 }
 
 FString UEMCPServerHttpUtils::MakeLogContext(const TCHAR* Phase, const FString& Endpoint, const FGuid& SessionId, const FString& Method, const FString& Accept)
@@ -98,47 +350,60 @@ FString UEMCPServerHttpUtils::MakeLogContext(const TCHAR* Phase, const FString&
 	return FString::Printf(TEXT("%s endpoint=%s method=%s session=%s accept=%s"), Phase, *EndpointString, *MethodString, *SessionString, *AcceptString);
 }
 
-void UEMCPServerHttpUtils::AppendSseEvent(FString& Output, const FString& Message)
+void UEMCPServerHttpUtils::AppendSseEvent(TArray<uint8>& Output, TConstArrayView<uint8> Utf8Message, int64 EventId)
 {
-	FString Normalized = Message;
-	Normalized.ReplaceInline(TEXT("\r\n"), TEXT("\n"));
-	Normalized.ReplaceInline(TEXT("\r"), TEXT("\n"));
-
-	TArray<FString> Lines;
-	Normalized.ParseIntoArrayLines(Lines);
-	if (Lines.IsEmpty())
+	const FAnsiStringView DataPrefix = ANSITEXTVIEW("data: ");
+	const auto AppendAscii = [&Output](FAnsiStringView Text)
 	{
-		Lines.Add(FString());
-	}
+		Output.Append(reinterpret_cast<const uint8*>(Text.GetData()), Text.Len());
+	};
 
-	for (const FString& Line : Lines)
+	if (EventId >= 0)
 	{
-		Output += TEXT("data: ");
-		Output += Line;
-		Output += TEXT("\n");
+		ANSICHAR IdLine[32];
+		const int32 Length = FCStringAnsi::Snprintf(IdLine, UE_ARRAY_COUNT(IdLine), "id: %lld\n", static_cast<long long>(EventId));
+		AppendAscii(FAnsiStringView(IdLine, FMath::Max(Length, 0)));
 	}
 
-	Output += TEXT("\n");
-}
-
-FString UEMCPServerHttpUtils::ExtractHeaderValue(const TMap<FString, TArray<FString>>& Headers, const FString& HeaderName)
-{
-	for (const TPair<FString, TArray<FString>>& Pair : Headers)
+	const uint8* Data = Utf8Message.GetData();
+	const int32 Num = Utf8Message.Num();
+	int32 LineStart = 0;
+	for (int32 Index = 0; Index < Num; ++Index)
 	{
-		if (!Pair.Key.Equals(HeaderName, ESearchCase::IgnoreCase))
+		const uint8 Byte = Data[Index];
+		if (Byte != '\n' && Byte != '\r')
 		{
 			continue;
 		}
 
-		for (const FString& Value : Pair.Value)
+		AppendAscii(DataPrefix);
+		Output.Append(Data + LineStart, Index - LineStart);
+		Output.Add('\n');
+
+		if (Byte == '\r' && Index + 1 < Num && Data[Index + 1] == '\n')
 		{
-			if (!Value.IsEmpty())
-			{
-				return Value;
-			}
+			++Index;
 		}
+		LineStart = Index + 1;
 	}
-	return FString();
+
+	AppendAscii(DataPrefix);
+	Output.Append(Data + LineStart, Num - LineStart);
+	AppendAscii(ANSITEXTVIEW("\n\n"));
+}
+
+void UEMCPServerHttpUtils::AppendSseComment(TArray<uint8>& Output, FAnsiStringView Comment)
+{
+	Output.Append(reinterpret_cast<const uint8*>(": "), 2);
+	Output.Append(reinterpret_cast<const uint8*>(Comment.GetData()), Comment.Len());
+	Output.Append(reinterpret_cast<const uint8*>("\n\n"), 2);
+}
+
+void UEMCPServerHttpUtils::AppendSseRetry(TArray<uint8>& Output, int32 RetryMilliseconds)
+{
+	ANSICHAR RetryLine[32];
+	const int32 Length = FCStringAnsi::Snprintf(RetryLine, UE_ARRAY_COUNT(RetryLine), "retry: %d\n\n", FMath::Max(RetryMilliseconds, 0));
+	Output.Append(reinterpret_cast<const uint8*>(RetryLine), FMath::Max(Length, 0));
 }
 
 bool UEMCPServerHttpUtils::TryParseSessionId(const FString& RawValue, FGuid& OutSessionId)
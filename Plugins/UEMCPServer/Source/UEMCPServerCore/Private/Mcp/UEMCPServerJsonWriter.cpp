@@ -0,0 +1,365 @@
+#include "Mcp/UEMCPServerJsonWriter.h"
+
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Misc/CString.h"
+#include "Misc/DateTime.h"
+
+FUEMCPServerJsonWriter::FUEMCPServerJsonWriter(TArray<uint8>& InBuffer)
+	: Buffer(InBuffer)
+	, bAfterKey(false)
+{
+}
+
+void FUEMCPServerJsonWriter::BeginObject()
+{
+	BeginValue();
+	Buffer.Add('{');
+	ScopeHasElements.Add(false);
+}
+
+void FUEMCPServerJsonWriter::BeginObject(FAnsiStringView Key)
+{
+	WriteKey(Key);
+	BeginObject();
+}
+
+void FUEMCPServerJsonWriter::EndObject()
+{
+	check(ScopeHasElements.Num() > 0);
+	ScopeHasElements.Pop(EAllowShrinking::No);
+	Buffer.Add('}');
+}
+
+void FUEMCPServerJsonWriter::BeginArray()
+{
+	BeginValue();
+	Buffer.Add('[');
+	ScopeHasElements.Add(false);
+}
+
+void FUEMCPServerJsonWriter::BeginArray(FAnsiStringView Key)
+{
+	WriteKey(Key);
+	BeginArray();
+}
+
+void FUEMCPServerJsonWriter::EndArray()
+{
+	check(ScopeHasElements.Num() > 0);
+	ScopeHasElements.Pop(EAllowShrinking::No);
+	Buffer.Add(']');
+}
+
+void FUEMCPServerJsonWriter::WriteKey(FAnsiStringView Key)
+{
+	BeginKey();
+	AppendQuoted(Key);
+	Buffer.Add(':');
+	bAfterKey = true;
+}
+
+void FUEMCPServerJsonWriter::WriteKey(FStringView Key)
+{
+	BeginKey();
+	AppendQuoted(Key);
+	Buffer.Add(':');
+	bAfterKey = true;
+}
+
+void FUEMCPServerJsonWriter::WriteString(FAnsiStringView Value)
+{
+	BeginValue();
+	AppendQuoted(Value);
+}
+
+void FUEMCPServerJsonWriter::WriteString(FStringView Value)
+{
+	BeginValue();
+	AppendQuoted(Value);
+}
+
+void FUEMCPServerJsonWriter::WriteString(FUtf8StringView Value)
+{
+	BeginValue();
+	AppendQuoted(Value);
+}
+
+void FUEMCPServerJsonWriter::WriteBool(bool bValue)
+{
+	BeginValue();
+	AppendAscii(bValue ? ANSITEXTVIEW("true") : ANSITEXTVIEW("false"));
+}
+
+void FUEMCPServerJsonWriter::WriteInt(int64 Value)
+{
+	BeginValue();
+	ANSICHAR Digits[32];
+	const int32 Length = FCStringAnsi::Snprintf(Digits, UE_ARRAY_COUNT(Digits), "%lld", static_cast<long long>(Value));
+	AppendAscii(FAnsiStringView(Digits, FMath::Max(Length, 0)));
+}
+
+void FUEMCPServerJsonWriter::WriteDouble(double Value)
+{
+	if (!FMath::IsFinite(Value))
+	{
+		// JSON has no representation for NaN or infinities.
+		WriteNull();
+		return;
+	}
+
+	if (Value == FMath::FloorToDouble(Value) && FMath::Abs(Value) < 9007199254740992.0)
+	{
+		WriteInt(static_cast<int64>(Value));
+		return;
+	}
+
+	BeginValue();
+	ANSICHAR Digits[40];
+	const int32 Length = FCStringAnsi::Snprintf(Digits, UE_ARRAY_COUNT(Digits), "%.17g", Value);
+	AppendAscii(FAnsiStringView(Digits, FMath::Max(Length, 0)));
+}
+
+void FUEMCPServerJsonWriter::WriteNull()
+{
+	BeginValue();
+	AppendAscii(ANSITEXTVIEW("null"));
+}
+
+void FUEMCPServerJsonWriter::WriteIso8601(const FDateTime& Value)
+{
+	BeginValue();
+
+	// Same layout as FDateTime::ToIso8601, without the intermediate FString.
+	ANSICHAR Text[40];
+	const int32 Length = FCStringAnsi::Snprintf(Text, UE_ARRAY_COUNT(Text), "\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\"",
+		Value.GetYear(), Value.GetMonth(), Value.GetDay(),
+		Value.GetHour(), Value.GetMinute(), Value.GetSecond(), Value.GetMillisecond());
+	AppendAscii(FAnsiStringView(Text, FMath::Max(Length, 0)));
+}
+
+void FUEMCPServerJsonWriter::WriteRaw(TConstArrayView<uint8> Json)
+{
+	BeginValue();
+	Buffer.Append(Json.GetData(), Json.Num());
+}
+
+void FUEMCPServerJsonWriter::WriteJsonValue(const TSharedPtr<FJsonValue>& Value)
+{
+	if (!Value.IsValid())
+	{
+		WriteNull();
+		return;
+	}
+
+	switch (Value->Type)
+	{
+	case EJson::String:
+		WriteString(Value->AsString());
+		break;
+	case EJson::Number:
+		WriteDouble(Value->AsNumber());
+		break;
+	case EJson::Boolean:
+		WriteBool(Value->AsBool());
+		break;
+	case EJson::Array:
+		BeginArray();
+		for (const TSharedPtr<FJsonValue>& Element : Value->AsArray())
+		{
+			WriteJsonValue(Element);
+		}
+		EndArray();
+		break;
+	case EJson::Object:
+		WriteJsonObject(Value->AsObject());
+		break;
+	case EJson::None:
+	case EJson::Null:
+	default:
+		WriteNull();
+		break;
+	}
+}
+
+void FUEMCPServerJsonWriter::WriteJsonObject(const TSharedPtr<FJsonObject>& Object)
+{
+	if (!Object.IsValid())
+	{
+		WriteNull();
+		return;
+	}
+
+	BeginObject();
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Object->Values)
+	{
+		WriteKey(FStringView(Pair.Key));
+		WriteJsonValue(Pair.Value);
+	}
+	EndObject();
+}
+
+void FUEMCPServerJsonWriter::BeginValue()
+{
+	if (bAfterKey)
+	{
+		bAfterKey = false;
+		return;
+	}
+
+	if (ScopeHasElements.Num() > 0)
+	{
+		bool& bHasElements = ScopeHasElements.Last();
+		if (bHasElements)
+		{
+			Buffer.Add(',');
+		}
+		bHasElements = true;
+	}
+}
+
+void FUEMCPServerJsonWriter::BeginKey()
+{
+	check(ScopeHasElements.Num() > 0 && !bAfterKey);
+	bool& bHasElements = ScopeHasElements.Last();
+	if (bHasElements)
+	{
+		Buffer.Add(',');
+	}
+	bHasElements = true;
+}
+
+void FUEMCPServerJsonWriter::AppendAscii(FAnsiStringView Text)
+{
+	Buffer.Append(reinterpret_cast<const uint8*>(Text.GetData()), Text.Len());
+}
+
+void FUEMCPServerJsonWriter::AppendQuoted(FAnsiStringView Value)
+{
+	Buffer.Reserve(Buffer.Num() + Value.Len() + 2);
+	Buffer.Add('"');
+	for (const ANSICHAR Char : Value)
+	{
+		AppendEscapedAscii(static_cast<uint8>(Char));
+	}
+	Buffer.Add('"');
+}
+
+void FUEMCPServerJsonWriter::AppendQuoted(FStringView Value)
+{
+	Buffer.Reserve(Buffer.Num() + Value.Len() + 2);
+	Buffer.Add('"');
+
+	const TCHAR* Chars = Value.GetData();
+	const int32 Length = Value.Len();
+	for (int32 Index = 0; Index < Length; ++Index)
+	{
+		uint32 Codepoint = static_cast<uint32>(Chars[Index]);
+		if (Codepoint < 0x80)
+		{
+			AppendEscapedAscii(static_cast<uint8>(Codepoint));
+			continue;
+		}
+
+		if (Codepoint >= 0xD800 && Codepoint <= 0xDBFF && Index + 1 < Length)
+		{
+			const uint32 LowSurrogate = static_cast<uint32>(Chars[Index + 1]);
+			if (LowSurrogate >= 0xDC00 && LowSurrogate <= 0xDFFF)
+			{
+				Codepoint = 0x10000 + ((Codepoint - 0xD800) << 10) + (LowSurrogate - 0xDC00);
+				++Index;
+			}
+		}
+		AppendCodepoint(Codepoint);
+	}
+
+	Buffer.Add('"');
+}
+
+void FUEMCPServerJsonWriter::AppendQuoted(FUtf8StringView Value)
+{
+	Buffer.Reserve(Buffer.Num() + Value.Len() + 2);
+	Buffer.Add('"');
+	for (const UTF8CHAR Char : Value)
+	{
+		const uint8 Byte = static_cast<uint8>(Char);
+		if (Byte < 0x80)
+		{
+			AppendEscapedAscii(Byte);
+		}
+		else
+		{
+			// Multi-byte sequences are already valid UTF-8 and need no escaping.
+			Buffer.Add(Byte);
+		}
+	}
+	Buffer.Add('"');
+}
+
+void FUEMCPServerJsonWriter::AppendEscapedAscii(uint8 Char)
+{
+	switch (Char)
+	{
+	case '"':
+		AppendAscii(ANSITEXTVIEW("\\\""));
+		return;
+	case '\\':
+		AppendAscii(ANSITEXTVIEW("\\\\"));
+		return;
+	case '\n':
+		AppendAscii(ANSITEXTVIEW("\\n"));
+		return;
+	case '\r':
+		AppendAscii(ANSITEXTVIEW("\\r"));
+		return;
+	case '\t':
+		AppendAscii(ANSITEXTVIEW("\\t"));
+		return;
+	case '\b':
+		AppendAscii(ANSITEXTVIEW("\\b"));
+		return;
+	case '\f':
+		AppendAscii(ANSITEXTVIEW("\\f"));
+		return;
+	default:
+		break;
+	}
+
+	if (Char < 0x20)
+	{
+		static const ANSICHAR HexDigits[] = "0123456789abcdef";
+		const ANSICHAR Escaped[] = { '\\', 'u', '0', '0', HexDigits[(Char >> 4) & 0xF], HexDigits[Char & 0xF] };
+		AppendAscii(FAnsiStringView(Escaped, UE_ARRAY_COUNT(Escaped)));
+		return;
+	}
+
+	Buffer.Add(Char);
+}
+
+void FUEMCPServerJsonWriter::AppendCodepoint(uint32 Codepoint)
+{
+	if ((Codepoint >= 0xD800 && Codepoint <= 0xDFFF) || Codepoint > 0x10FFFF)
+	{
+		// Unpaired surrogate or out of range; emit U+FFFD so the output stays valid UTF-8.
+		Codepoint = 0xFFFD;
+	}
+
+	if (Codepoint < 0x800)
+	{
+		Buffer.Add(static_cast<uint8>(0xC0 | (Codepoint >> 6)));
+		Buffer.Add(static_cast<uint8>(0x80 | (Codepoint & 0x3F)));
+	}
+	else if (Codepoint < 0x10000)
+	{
+		Buffer.Add(static_cast<uint8>(0xE0 | (Codepoint >> 12)));
+		Buffer.Add(static_cast<uint8>(0x80 | ((Codepoint >> 6) & 0x3F)));
+		Buffer.Add(static_cast<uint8>(0x80 | (Codepoint & 0x3F)));
+	}
+	else
+	{
+		Buffer.Add(static_cast<uint8>(0xF0 | (Codepoint >> 18)));
+		Buffer.Add(static_cast<uint8>(0x80 | ((Codepoint >> 12) & 0x3F)));
+		Buffer.Add(static_cast<uint8>(0x80 | ((Codepoint >> 6) & 0x3F)));
+		Buffer.Add(static_cast<uint8>(0x80 | (Codepoint & 0x3F)));
+	}
+}
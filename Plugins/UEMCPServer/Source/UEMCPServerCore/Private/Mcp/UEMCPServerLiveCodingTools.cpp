@@ -0,0 +1,453 @@
+#include "Mcp/UEMCPServerLiveCodingTools.h"
+#include "Mcp/UEMCPServerJsonWriter.h"
+#include "Mcp/UEMCPServerMcpSchema.h"
+#include "Mcp/UEMCPServerMcpSettings.h"
+#include "Mcp/UEMCPServerToolRegistry.h"
+#include "IUEMCPServerLiveCodingProvider.h"
+#include "UEMCPServerLiveCodingTypes.h"
+#include "UEMCPServerLog.h"
+
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+
+namespace UEMCPServer::Mcp
+{
+	static const TCHAR* CompileToolName = TEXT("liveCoding_compile");
+	static const TCHAR* StatusToolName = TEXT("liveCoding_status");
+	static const TCHAR* HistoryToolName = TEXT("liveCoding_history");
+
+	/** Summaries returned by liveCoding_history when the client passes no limit. */
+	static constexpr int32 DefaultHistoryLimit = 20;
+}
+
+namespace
+{
+	/** Writes the status fields into the currently open object and returns the summary message. */
+	FString BuildLiveCodingStatus(const IUEMCPServerLiveCodingProvider& Provider, FUEMCPServerJsonWriter& Writer, const FString& MessageOverride = FString(), bool bCompileStarted = false,
+		const FUEMCPServerLogQuery& LogQuery = FUEMCPServerLogQuery(), const FUEMCPServerDiagnosticFilter& DiagnosticFilter = FUEMCPServerDiagnosticFilter())
+	{
+		// Held for the whole write; the log is read in place, never copied.
+		const FUEMCPServerCompileSnapshotRef Snapshot = Provider.GetLastCompileSnapshot();
+		const FUEMCPServerLiveCodingLogBuffer& Log = *Snapshot->Log;
+		const FUEMCPServerLogPage LogPage = Log.SelectPage(LogQuery);
+		const FString& SnapshotError = Snapshot->ErrorMessage;
+		const bool bInProgress = Snapshot->bCompileInProgress;
+		const bool bHasSnapshotResult = Snapshot->bHasResult;
+
+		const FString ResultString = UEMCPServer::CompileResultToString(Snapshot->Result);
+
+		FString Message;
+		if (!MessageOverride.IsEmpty())
+		{
+			Message = MessageOverride;
+		}
+		else if (!SnapshotError.IsEmpty())
+		{
+			Message = SnapshotError;
+		}
+		else if (bInProgress)
+		{
+			Message = TEXT("Compile in progress.");
+		}
+		else if (!bHasSnapshotResult)
+		{
+			Message = TEXT("No compile has been executed yet.");
+		}
+		else
+		{
+			Message = FString::Printf(TEXT("Last compile result: %s."), *ResultString);
+		}
+
+		const bool bReportError = MessageOverride.IsEmpty() && !SnapshotError.IsEmpty();
+		Writer.WriteStringField("status", bReportError ? "error" : "ok");
+		Writer.WriteStringField("compileResult", ResultString);
+		Writer.WriteBoolField("compileInProgress", bInProgress);
+		Writer.WriteBoolField("hasPreviousResult", bHasSnapshotResult);
+		Writer.WriteBoolField("compileStarted", bCompileStarted);
+
+		if (Snapshot->Timestamp.GetTicks() > 0)
+		{
+			Writer.WriteIso8601Field("timestampUtc", Snapshot->Timestamp);
+		}
+
+		Writer.WriteStringField("message", Message);
+
+		Writer.WriteIntField("nextSequence", LogPage.NextSequence);
+		Writer.WriteBoolField("hasMoreLog", LogPage.RemainingEntries > 0);
+		Writer.WriteIntField("totalLogEntries", LogPage.TotalEntries);
+
+		Writer.BeginArray("log");
+		for (int32 Index = LogPage.FirstIndex; Index < LogPage.FirstIndex + LogPage.NumEntries; ++Index)
+		{
+			Writer.BeginObject();
+			Writer.WriteIntField("sequence", Log.GetSequence(Index));
+			Writer.WriteIso8601Field("timeUtc", Log.GetTimestamp(Index));
+			Writer.WriteStringField("category", FNameBuilder(Log.GetCategory(Index)).ToView());
+			Writer.WriteStringField("verbosity", FStringView(::ToString(Log.GetVerbosity(Index))));
+			Writer.WriteStringField("message", Log.GetMessage(Index));
+			Writer.EndObject();
+		}
+		Writer.EndArray();
+
+		const FUEMCPServerCompileDiagnostics& Diagnostics = *Snapshot->Diagnostics;
+		Writer.WriteIntField("errorCount", Diagnostics.NumErrors());
+		Writer.WriteIntField("warningCount", Diagnostics.NumWarnings());
+		Writer.BeginArray("diagnostics");
+		for (const FUEMCPServerCompileDiagnostic& Diagnostic : Diagnostics.GetDiagnostics())
+		{
+			if (!DiagnosticFilter.Matches(Diagnostic))
+			{
+				continue;
+			}
+
+			Writer.BeginObject();
+			Writer.WriteIntField("sequence", Diagnostic.Sequence);
+			Writer.WriteStringField("severity", FStringView(UEMCPServer::DiagnosticSeverityToString(Diagnostic.Severity)));
+			Writer.WriteStringField("file", Diagnostic.File);
+			Writer.WriteIntField("line", Diagnostic.Line);
+			Writer.WriteIntField("column", Diagnostic.Column);
+			Writer.WriteStringField("code", Diagnostic.Code);
+			Writer.WriteStringField("message", Diagnostic.Message);
+			Writer.EndObject();
+		}
+		Writer.EndArray();
+
+		return Message;
+	}
+
+	/**
+	 * A liveCoding_compile call held open until the compile finishes or the timeout elapses. Owned by the active
+	 * waiter list; both wake-ups are bound weakly and everything runs on the game thread.
+	 */
+	class FCompileWaiter : public TSharedFromThis<FCompileWaiter>
+	{
+	public:
+		FCompileWaiter(IUEMCPServerLiveCodingProvider& InProvider, FUEMCPServerToolCompletion&& InOnComplete, bool bInCompileStarted)
+			: Provider(InProvider)
+			, OnComplete(MoveTemp(InOnComplete))
+			, bCompileStarted(bInCompileStarted)
+		{
+		}
+
+		void Start(double TimeoutSeconds)
+		{
+			check(IsInGameThread());
+			Timeout = TimeoutSeconds;
+			GetActiveWaiters().Add(AsShared());
+			FinishedHandle = Provider.OnCompileFinished().AddSP(this, &FCompileWaiter::HandleCompileFinished);
+			TimeoutHandle = FTSTicker::GetCoreTicker().AddTicker(
+				FTickerDelegate::CreateSP(this, &FCompileWaiter::HandleTimeout),
+				static_cast<float>(TimeoutSeconds));
+		}
+
+		/** Answers with the current snapshot; MessageOverride explains why the wait ended early. */
+		void Finish(const FString& MessageOverride)
+		{
+			check(IsInGameThread());
+			if (!OnComplete)
+			{
+				return;
+			}
+
+			const TSharedRef<FCompileWaiter> KeepAlive = AsShared();
+			Provider.OnCompileFinished().Remove(FinishedHandle);
+			FTSTicker::GetCoreTicker().RemoveTicker(TimeoutHandle);
+			GetActiveWaiters().Remove(KeepAlive);
+
+			FUEMCPServerToolCompletion Completion = MoveTemp(OnComplete);
+			OnComplete = nullptr;
+
+			IUEMCPServerLiveCodingProvider& ProviderRef = Provider;
+			const bool bStarted = bCompileStarted;
+			Completion(FUEMCPServerToolResult::Make([&ProviderRef, &MessageOverride, bStarted](FUEMCPServerJsonWriter& Writer)
+			{
+				return BuildLiveCodingStatus(ProviderRef, Writer, MessageOverride, bStarted);
+			}));
+		}
+
+		static TArray<TSharedRef<FCompileWaiter>>& GetActiveWaiters()
+		{
+			static TArray<TSharedRef<FCompileWaiter>> ActiveWaiters;
+			return ActiveWaiters;
+		}
+
+	private:
+		void HandleCompileFinished(ELiveCodingCompileResult Result)
+		{
+			Finish(FString());
+		}
+
+		bool HandleTimeout(float DeltaTime)
+		{
+			Finish(FString::Printf(TEXT("Compile still running after %.0f seconds. Poll liveCoding_status for the result."), Timeout));
+			return false;
+		}
+
+		IUEMCPServerLiveCodingProvider& Provider;
+		FUEMCPServerToolCompletion OnComplete;
+		FDelegateHandle FinishedHandle;
+		FTSTicker::FDelegateHandle TimeoutHandle;
+		double Timeout = 0.0;
+		bool bCompileStarted;
+	};
+
+	void HandleCompileTool(IUEMCPServerLiveCodingProvider& Provider, double WaitTimeoutSeconds, const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		bool bWaitForCompletion = false;
+		Call.Arguments->TryGetBoolField(TEXT("waitForCompletion"), bWaitForCompletion);
+
+		FString ErrorMessage;
+		if (!Provider.TryBeginCompile(FString::Printf(TEXT("mcp:%s"), *Call.SessionId.ToString()), ErrorMessage))
+		{
+			if (bWaitForCompletion && Provider.GetLastCompileSnapshot()->bCompileInProgress)
+			{
+				// Someone else's compile is already running; its result answers this call just as well.
+				MakeShared<FCompileWaiter>(Provider, MoveTemp(OnComplete), /*bCompileStarted=*/false)->Start(WaitTimeoutSeconds);
+				UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s waiting on the running Live Coding compile."), *Call.SessionId.ToString());
+				return;
+			}
+
+			OnComplete(FUEMCPServerToolResult::Make([&ErrorMessage](FUEMCPServerJsonWriter& Writer)
+			{
+				Writer.WriteStringField("status", "error");
+				Writer.WriteStringField("message", ErrorMessage);
+				Writer.WriteBoolField("compileInProgress", true);
+				Writer.WriteBoolField("compileStarted", false);
+				return ErrorMessage;
+			}, /*bIsError=*/true));
+			return;
+		}
+
+		if (bWaitForCompletion)
+		{
+			// Subscribe before the compile is scheduled so the finish event cannot be missed.
+			MakeShared<FCompileWaiter>(Provider, MoveTemp(OnComplete), /*bCompileStarted=*/true)->Start(WaitTimeoutSeconds);
+		}
+		else
+		{
+			OnComplete(FUEMCPServerToolResult::Make([&Provider](FUEMCPServerJsonWriter& Writer)
+			{
+				return BuildLiveCodingStatus(Provider, Writer, TEXT("Compile queued. Poll liveCoding_status for updates."), /*bCompileStarted=*/true);
+			}));
+		}
+
+		IUEMCPServerLiveCodingProvider* ProviderPtr = &Provider;
+		AsyncTask(ENamedThreads::GameThread, [ProviderPtr]()
+		{
+			ProviderPtr->ExecuteCompileOnGameThread();
+		});
+
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s queued Live Coding compile%s."), *Call.SessionId.ToString(),
+			bWaitForCompletion ? TEXT(" and is waiting for it") : TEXT(""));
+	}
+
+	void HandleStatusTool(const IUEMCPServerLiveCodingProvider& Provider, const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		FUEMCPServerLogQuery LogQuery;
+		Call.Arguments->TryGetNumberField(TEXT("sinceSequence"), LogQuery.SinceSequence);
+		Call.Arguments->TryGetNumberField(TEXT("limit"), LogQuery.Limit);
+		Call.Arguments->TryGetBoolField(TEXT("tail"), LogQuery.bTail);
+		LogQuery.SinceSequence = FMath::Max<int64>(LogQuery.SinceSequence, 0);
+
+		FUEMCPServerDiagnosticFilter DiagnosticFilter;
+		FString SeverityText;
+		if (Call.Arguments->TryGetStringField(TEXT("severity"), SeverityText))
+		{
+			EUEMCPServerDiagnosticSeverity Severity;
+			if (!UEMCPServer::DiagnosticSeverityFromString(SeverityText, Severity))
+			{
+				OnComplete(FUEMCPServerToolResult::Make([&SeverityText](FUEMCPServerJsonWriter& Writer)
+				{
+					const FString Message = FString::Printf(TEXT("Unknown severity '%s'; expected error or warning."), *SeverityText);
+					Writer.WriteStringField("status", "error");
+					Writer.WriteStringField("message", Message);
+					return Message;
+				}, /*bIsError=*/true));
+				return;
+			}
+			DiagnosticFilter.Severity = Severity;
+		}
+		if (Call.Arguments->TryGetStringField(TEXT("file"), DiagnosticFilter.File))
+		{
+			DiagnosticFilter.File.ReplaceCharInline(TEXT('\\'), TEXT('/'));
+		}
+
+		OnComplete(FUEMCPServerToolResult::Make([&Provider, &LogQuery, &DiagnosticFilter](FUEMCPServerJsonWriter& Writer)
+		{
+			return BuildLiveCodingStatus(Provider, Writer, FString(), /*bCompileStarted=*/false, LogQuery, DiagnosticFilter);
+		}));
+
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s requested Live Coding status."), *Call.SessionId.ToString());
+	}
+
+	void WriteCompileSummaryFields(FUEMCPServerJsonWriter& Writer, const FUEMCPServerCompileSummary& Summary)
+	{
+		Writer.WriteIntField("id", Summary.Id);
+		Writer.WriteIso8601Field("startUtc", Summary.StartTime);
+		Writer.WriteIso8601Field("finishUtc", Summary.FinishTime);
+		Writer.WriteIntField("durationMs", FMath::Max<int64>((Summary.FinishTime - Summary.StartTime).GetTicks() / ETimespan::TicksPerMillisecond, 0));
+		Writer.WriteStringField("compileResult", UEMCPServer::CompileResultToString(Summary.Result));
+		Writer.WriteStringField("trigger", Summary.TriggerSource);
+		Writer.WriteIntField("lines", Summary.NumLines);
+		Writer.WriteIntField("errors", Summary.NumErrors);
+		Writer.WriteIntField("warnings", Summary.NumWarnings);
+	}
+
+	void HandleHistoryTool(const IUEMCPServerLiveCodingProvider& Provider, const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		const FUEMCPServerCompileHistory* History = Provider.GetCompileHistory();
+		if (!History)
+		{
+			OnComplete(FUEMCPServerToolResult::Make([](FUEMCPServerJsonWriter& Writer)
+			{
+				const FString Message = TEXT("Compile history is disabled (CompileHistoryCapacity is 0).");
+				Writer.WriteStringField("status", "error");
+				Writer.WriteStringField("message", Message);
+				return Message;
+			}, /*bIsError=*/true));
+			return;
+		}
+
+		int64 RecordId = 0;
+		if (!Call.Arguments->TryGetNumberField(TEXT("id"), RecordId))
+		{
+			int32 Limit = UEMCPServer::Mcp::DefaultHistoryLimit;
+			Call.Arguments->TryGetNumberField(TEXT("limit"), Limit);
+			const TArray<FUEMCPServerCompileSummary> Summaries = History->GetSummaries(FMath::Max(Limit, 0));
+
+			OnComplete(FUEMCPServerToolResult::Make([&Summaries, History](FUEMCPServerJsonWriter& Writer)
+			{
+				const FString Message = FString::Printf(TEXT("%d archived compile(s), newest first."), Summaries.Num());
+				Writer.WriteStringField("status", "ok");
+				Writer.WriteStringField("message", Message);
+				Writer.WriteIntField("capacity", History->GetCapacity());
+				Writer.BeginArray("compiles");
+				for (const FUEMCPServerCompileSummary& Summary : Summaries)
+				{
+					Writer.BeginObject();
+					WriteCompileSummaryFields(Writer, Summary);
+					Writer.EndObject();
+				}
+				Writer.EndArray();
+				return Message;
+			}));
+			UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s listed the Live Coding compile history."), *Call.SessionId.ToString());
+			return;
+		}
+
+		const FUEMCPServerCompileRecordPtr Record = History->FindRecord(RecordId);
+		if (!Record.IsValid())
+		{
+			OnComplete(FUEMCPServerToolResult::Make([RecordId](FUEMCPServerJsonWriter& Writer)
+			{
+				const FString Message = FString::Printf(TEXT("No archived compile with id %lld; it may have rolled out of the history."), RecordId);
+				Writer.WriteStringField("status", "error");
+				Writer.WriteStringField("message", Message);
+				return Message;
+			}, /*bIsError=*/true));
+			return;
+		}
+
+		FUEMCPServerLogQuery LogQuery;
+		Call.Arguments->TryGetNumberField(TEXT("sinceSequence"), LogQuery.SinceSequence);
+		Call.Arguments->TryGetNumberField(TEXT("limit"), LogQuery.Limit);
+		Call.Arguments->TryGetBoolField(TEXT("tail"), LogQuery.bTail);
+		LogQuery.SinceSequence = FMath::Max<int64>(LogQuery.SinceSequence, 0);
+
+		OnComplete(FUEMCPServerToolResult::Make([&Record, &LogQuery](FUEMCPServerJsonWriter& Writer)
+		{
+			// Everything below is read straight out of the mapped history file.
+			const FUEMCPServerCompileSummary& Summary = Record->GetSummary();
+			const FUEMCPServerLogPage LogPage = Record->SelectPage(LogQuery);
+			const FString Message = FString::Printf(TEXT("Compile %lld: %s."), Summary.Id, *UEMCPServer::CompileResultToString(Summary.Result));
+
+			Writer.WriteStringField("status", "ok");
+			Writer.WriteStringField("message", Message);
+			WriteCompileSummaryFields(Writer, Summary);
+			Writer.WriteStringField("errorMessage", Record->GetErrorMessage());
+
+			Writer.WriteIntField("nextSequence", LogPage.NextSequence);
+			Writer.WriteBoolField("hasMoreLog", LogPage.RemainingEntries > 0);
+			Writer.WriteIntField("totalLogEntries", LogPage.TotalEntries);
+
+			Writer.BeginArray("log");
+			for (int32 Index = LogPage.FirstIndex; Index < LogPage.FirstIndex + LogPage.NumEntries; ++Index)
+			{
+				Writer.BeginObject();
+				Writer.WriteIntField("sequence", Record->GetSequence(Index));
+				Writer.WriteIso8601Field("timeUtc", Record->GetTimestamp(Index));
+				Writer.WriteStringField("category", Record->GetCategory(Index));
+				Writer.WriteStringField("verbosity", FStringView(::ToString(Record->GetVerbosity(Index))));
+				Writer.WriteStringField("message", Record->GetMessage(Index));
+				Writer.EndObject();
+			}
+			Writer.EndArray();
+			return Message;
+		}));
+
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s fetched archived compile %lld."), *Call.SessionId.ToString(), RecordId);
+	}
+}
+
+void UEMCPServerLiveCodingTools::Register(FUEMCPServerToolRegistry& Registry, IUEMCPServerLiveCodingProvider& Provider, const FUEMCPServerMcpServerSettings& Settings)
+{
+	IUEMCPServerLiveCodingProvider* ProviderPtr = &Provider;
+	const double WaitTimeoutSeconds = Settings.CompileWaitTimeoutSeconds;
+
+	FUEMCPServerToolDefinition CompileTool;
+	CompileTool.Name = UEMCPServer::Mcp::CompileToolName;
+	CompileTool.Title = TEXT("Trigger Live Coding Compile");
+	CompileTool.Description = TEXT("Trigger a UE Live Coding compile. With waitForCompletion the call returns once the compile has finished, with its final result and log.");
+	CompileTool.InputSchema = UEMCPServerMcpSchema::BuildToolInputSchema(true);
+	CompileTool.OutputSchema = UEMCPServerMcpSchema::BuildLiveCodingOutputSchema();
+	CompileTool.Affinity = EUEMCPServerToolAffinity::GameThread;
+	CompileTool.Handler = [ProviderPtr, WaitTimeoutSeconds](const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		HandleCompileTool(*ProviderPtr, WaitTimeoutSeconds, Call, MoveTemp(OnComplete));
+	};
+	Registry.RegisterTool(MoveTemp(CompileTool));
+
+	FUEMCPServerToolDefinition StatusTool;
+	StatusTool.Name = UEMCPServer::Mcp::StatusToolName;
+	StatusTool.Title = TEXT("Get Live Coding Status");
+	StatusTool.Description = TEXT("Return the most recent Live Coding compile snapshot without starting a new compile. Pass the previous nextSequence as sinceSequence to fetch only new log lines. Compiler errors and warnings are returned parsed in diagnostics; filter them with severity and file, and pass limit 0 to skip the raw log.");
+	StatusTool.InputSchema = UEMCPServerMcpSchema::BuildStatusInputSchema();
+	StatusTool.OutputSchema = UEMCPServerMcpSchema::BuildLiveCodingOutputSchema();
+	StatusTool.bReadOnlyHint = true;
+	StatusTool.Affinity = EUEMCPServerToolAffinity::AnyThread;
+	StatusTool.Handler = [ProviderPtr](const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		HandleStatusTool(*ProviderPtr, Call, MoveTemp(OnComplete));
+	};
+	Registry.RegisterTool(MoveTemp(StatusTool));
+
+	FUEMCPServerToolDefinition HistoryTool;
+	HistoryTool.Name = UEMCPServer::Mcp::HistoryToolName;
+	HistoryTool.Title = TEXT("Get Live Coding Compile History");
+	HistoryTool.Description = TEXT("List recent Live Coding compiles, newest first, including those from earlier editor sessions. Pass an id to fetch that compile's log, paged like liveCoding_status.");
+	HistoryTool.InputSchema = UEMCPServerMcpSchema::BuildHistoryInputSchema();
+	HistoryTool.bReadOnlyHint = true;
+	HistoryTool.Affinity = EUEMCPServerToolAffinity::AnyThread;
+	HistoryTool.Handler = [ProviderPtr](const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		HandleHistoryTool(*ProviderPtr, Call, MoveTemp(OnComplete));
+	};
+	Registry.RegisterTool(MoveTemp(HistoryTool));
+}
+
+void UEMCPServerLiveCodingTools::Unregister(FUEMCPServerToolRegistry& Registry)
+{
+	Registry.UnregisterTool(UEMCPServer::Mcp::CompileToolName);
+	Registry.UnregisterTool(UEMCPServer::Mcp::StatusToolName);
+	Registry.UnregisterTool(UEMCPServer::Mcp::HistoryToolName);
+	CancelWaits();
+}
+
+void UEMCPServerLiveCodingTools::CancelWaits()
+{
+	const TArray<TSharedRef<FCompileWaiter>> Waiters = FCompileWaiter::GetActiveWaiters();
+	for (const TSharedRef<FCompileWaiter>& Waiter : Waiters)
+	{
+		Waiter->Finish(TEXT("MCP server is shutting down; the compile result is no longer being awaited."));
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FUEMCPServerToolRegistry;
+class IUEMCPServerLiveCodingProvider;
+struct FUEMCPServerMcpServerSettings;
+
+/**
+ * The liveCoding_* MCP tools, backed by a Live Coding provider.
+ */
+class UEMCPServerLiveCodingTools
+{
+public:
+	static void Register(FUEMCPServerToolRegistry& Registry, IUEMCPServerLiveCodingProvider& Provider, const FUEMCPServerMcpServerSettings& Settings);
+
+	/** Removes the tools and answers every call still waiting for a compile. */
+	static void Unregister(FUEMCPServerToolRegistry& Registry);
+
+	/** Answers every call still waiting for a compile with the current status; game thread only. */
+	static void CancelWaits();
+};
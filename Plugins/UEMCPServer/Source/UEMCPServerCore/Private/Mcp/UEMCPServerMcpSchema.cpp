@@ -1,12 +1,46 @@
 #include "Mcp/UEMCPServerMcpSchema.h"
+#include "Mcp/UEMCPServerJsonWriter.h"
+#include "Mcp/UEMCPServerToolRegistry.h"
+#include "UEMCPServerLog.h"
 
 #include "Dom/JsonObject.h"
 #include "Dom/JsonValue.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
 
-namespace UEMCPServer::Mcp
+namespace
 {
-	static const TCHAR* CompileToolName = TEXT("liveCoding_compile");
-	static const TCHAR* StatusToolName = TEXT("liveCoding_status");
+	using FSerializedToolsList = TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe>;
+
+	struct FToolsListCache
+	{
+		FCriticalSection Mutex;
+		TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Serialized;
+		uint32 Crc = 0;
+		FSimpleMulticastDelegate OnChanged;
+	};
+
+	FToolsListCache& GetToolsListCache()
+	{
+		static FToolsListCache Cache;
+		return Cache;
+	}
+
+	FSerializedToolsList SerializeToolsList()
+	{
+		TArray<TSharedPtr<FJsonValue>> Tools;
+		UEMCPServerMcpSchema::PopulateToolsList(Tools);
+
+		TSharedRef<TArray<uint8>, ESPMode::ThreadSafe> Bytes = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		FUEMCPServerJsonWriter Writer(*Bytes);
+		Writer.BeginArray();
+		for (const TSharedPtr<FJsonValue>& Tool : Tools)
+		{
+			Writer.WriteJsonValue(Tool);
+		}
+		Writer.EndArray();
+		return Bytes;
+	}
 }
 
 TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildToolInputSchema(bool bIncludeWaitFlag)
@@ -19,7 +53,7 @@ TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildToolInputSchema(bool bInclude
 	{
 		TSharedRef<FJsonObject> WaitProp = MakeShared<FJsonObject>();
 		WaitProp->SetStringField(TEXT("type"), TEXT("boolean"));
-		WaitProp->SetStringField(TEXT("description"), TEXT("Reserved for future use. When true, the server will wait for the compile to finish before responding."));
+		WaitProp->SetStringField(TEXT("description"), TEXT("When true, the response is held until the compile finishes (or the server's wait timeout elapses) and carries the final result and log."));
 		Properties->SetObjectField(TEXT("waitForCompletion"), WaitProp);
 	}
 	Schema->SetObjectField(TEXT("properties"), Properties);
@@ -28,6 +62,78 @@ TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildToolInputSchema(bool bInclude
 	return Schema;
 }
 
+namespace
+{
+	/** The sinceSequence/limit/tail log cursor shared by liveCoding_status and liveCoding_history. */
+	TSharedRef<FJsonObject> BuildLogCursorInputSchema()
+	{
+		TSharedRef<FJsonObject> Schema = UEMCPServerMcpSchema::BuildToolInputSchema(false);
+		const TSharedPtr<FJsonObject> Properties = Schema->GetObjectField(TEXT("properties"));
+
+		TSharedRef<FJsonObject> SinceProp = MakeShared<FJsonObject>();
+		SinceProp->SetStringField(TEXT("type"), TEXT("integer"));
+		SinceProp->SetNumberField(TEXT("minimum"), 0);
+		SinceProp->SetStringField(TEXT("description"), TEXT("Only return log entries after this sequence; pass the nextSequence of the previous call. Defaults to 0 (the whole log)."));
+		Properties->SetObjectField(TEXT("sinceSequence"), SinceProp);
+
+		TSharedRef<FJsonObject> LimitProp = MakeShared<FJsonObject>();
+		LimitProp->SetStringField(TEXT("type"), TEXT("integer"));
+		LimitProp->SetNumberField(TEXT("minimum"), 0);
+		LimitProp->SetStringField(TEXT("description"), TEXT("Maximum number of log entries to return. Unlimited when omitted."));
+		Properties->SetObjectField(TEXT("limit"), LimitProp);
+
+		TSharedRef<FJsonObject> TailProp = MakeShared<FJsonObject>();
+		TailProp->SetStringField(TEXT("type"), TEXT("boolean"));
+		TailProp->SetStringField(TEXT("description"), TEXT("When the limit applies, return the newest entries instead of the oldest."));
+		Properties->SetObjectField(TEXT("tail"), TailProp);
+
+		return Schema;
+	}
+}
+
+TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildStatusInputSchema()
+{
+	TSharedRef<FJsonObject> Schema = BuildLogCursorInputSchema();
+	const TSharedPtr<FJsonObject> Properties = Schema->GetObjectField(TEXT("properties"));
+
+	TArray<TSharedPtr<FJsonValue>> Severities;
+	Severities.Add(MakeShared<FJsonValueString>(TEXT("error")));
+	Severities.Add(MakeShared<FJsonValueString>(TEXT("warning")));
+
+	TSharedRef<FJsonObject> SeverityProp = MakeShared<FJsonObject>();
+	SeverityProp->SetStringField(TEXT("type"), TEXT("string"));
+	SeverityProp->SetArrayField(TEXT("enum"), Severities);
+	SeverityProp->SetStringField(TEXT("description"), TEXT("Only return diagnostics of this severity."));
+	Properties->SetObjectField(TEXT("severity"), SeverityProp);
+
+	TSharedRef<FJsonObject> FileProp = MakeShared<FJsonObject>();
+	FileProp->SetStringField(TEXT("type"), TEXT("string"));
+	FileProp->SetStringField(TEXT("description"), TEXT("Only return diagnostics whose file path contains this text (case-insensitive, either slash direction)."));
+	Properties->SetObjectField(TEXT("file"), FileProp);
+
+	return Schema;
+}
+
+TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildHistoryInputSchema()
+{
+	TSharedRef<FJsonObject> Schema = BuildLogCursorInputSchema();
+	const TSharedPtr<FJsonObject> Properties = Schema->GetObjectField(TEXT("properties"));
+
+	TSharedRef<FJsonObject> IdProp = MakeShared<FJsonObject>();
+	IdProp->SetStringField(TEXT("type"), TEXT("integer"));
+	IdProp->SetNumberField(TEXT("minimum"), 1);
+	IdProp->SetStringField(TEXT("description"), TEXT("Id of an archived compile whose log to return. When omitted, the tool lists compile summaries instead."));
+	Properties->SetObjectField(TEXT("id"), IdProp);
+
+	TSharedRef<FJsonObject> LimitProp = MakeShared<FJsonObject>();
+	LimitProp->SetStringField(TEXT("type"), TEXT("integer"));
+	LimitProp->SetNumberField(TEXT("minimum"), 0);
+	LimitProp->SetStringField(TEXT("description"), TEXT("Without id, the maximum number of summaries (default 20). With id, the maximum number of log entries."));
+	Properties->SetObjectField(TEXT("limit"), LimitProp);
+
+	return Schema;
+}
+
 TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildLiveCodingOutputSchema()
 {
 	TSharedRef<FJsonObject> Schema = MakeShared<FJsonObject>();
@@ -65,9 +171,22 @@ TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildLiveCodingOutputSchema()
 	Properties->SetObjectField(TEXT("compileStarted"), MakeBooleanProperty(TEXT("True if the request queued a new compile.")));
 	Properties->SetObjectField(TEXT("timestampUtc"), MakeStringProperty(TEXT("UTC timestamp of the snapshot when available.")));
 
+	auto MakeIntegerProperty = [](const FString& Description)
+	{
+		TSharedRef<FJsonObject> Prop = MakeShared<FJsonObject>();
+		Prop->SetStringField(TEXT("type"), TEXT("integer"));
+		Prop->SetStringField(TEXT("description"), Description);
+		return Prop;
+	};
+
+	Properties->SetObjectField(TEXT("nextSequence"), MakeIntegerProperty(TEXT("Cursor to pass as sinceSequence to continue after the returned log entries.")));
+	Properties->SetObjectField(TEXT("hasMoreLog"), MakeBooleanProperty(TEXT("True if the limit left newer log entries out.")));
+	Properties->SetObjectField(TEXT("totalLogEntries"), MakeIntegerProperty(TEXT("Number of entries in the whole compile log.")));
+
 	TSharedRef<FJsonObject> LogItems = MakeShared<FJsonObject>();
 	LogItems->SetStringField(TEXT("type"), TEXT("object"));
 	TSharedPtr<FJsonObject> LogProperties = MakeShared<FJsonObject>();
+	LogProperties->SetObjectField(TEXT("sequence"), MakeIntegerProperty(TEXT("Sequence number of the log entry.")));
 	LogProperties->SetObjectField(TEXT("timeUtc"), MakeStringProperty(TEXT("Timestamp of the log entry in UTC.")));
 	LogProperties->SetObjectField(TEXT("category"), MakeStringProperty(TEXT("Log category.")));
 	LogProperties->SetObjectField(TEXT("verbosity"), MakeStringProperty(TEXT("Verbosity string.")));
@@ -80,6 +199,27 @@ TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildLiveCodingOutputSchema()
 	LogArray->SetObjectField(TEXT("items"), LogItems);
 	Properties->SetObjectField(TEXT("log"), LogArray);
 
+	Properties->SetObjectField(TEXT("errorCount"), MakeIntegerProperty(TEXT("Errors parsed from the compile log, before any filter.")));
+	Properties->SetObjectField(TEXT("warningCount"), MakeIntegerProperty(TEXT("Warnings parsed from the compile log, before any filter.")));
+
+	TSharedRef<FJsonObject> DiagnosticItems = MakeShared<FJsonObject>();
+	DiagnosticItems->SetStringField(TEXT("type"), TEXT("object"));
+	TSharedPtr<FJsonObject> DiagnosticProperties = MakeShared<FJsonObject>();
+	DiagnosticProperties->SetObjectField(TEXT("sequence"), MakeIntegerProperty(TEXT("Sequence of the log entry the diagnostic was parsed from.")));
+	DiagnosticProperties->SetObjectField(TEXT("severity"), MakeStringProperty(TEXT("error or warning.")));
+	DiagnosticProperties->SetObjectField(TEXT("file"), MakeStringProperty(TEXT("File the diagnostic points at, with forward slashes; empty for tool-level diagnostics.")));
+	DiagnosticProperties->SetObjectField(TEXT("line"), MakeIntegerProperty(TEXT("1-based line, or 0 when unknown.")));
+	DiagnosticProperties->SetObjectField(TEXT("column"), MakeIntegerProperty(TEXT("1-based column, or 0 when unknown.")));
+	DiagnosticProperties->SetObjectField(TEXT("code"), MakeStringProperty(TEXT("Compiler, linker or warning-flag code such as C2065, LNK2019 or -Wunused-variable.")));
+	DiagnosticProperties->SetObjectField(TEXT("message"), MakeStringProperty(TEXT("Diagnostic text.")));
+	DiagnosticItems->SetObjectField(TEXT("properties"), DiagnosticProperties);
+	DiagnosticItems->SetBoolField(TEXT("additionalProperties"), false);
+
+	TSharedRef<FJsonObject> DiagnosticArray = MakeShared<FJsonObject>();
+	DiagnosticArray->SetStringField(TEXT("type"), TEXT("array"));
+	DiagnosticArray->SetObjectField(TEXT("items"), DiagnosticItems);
+	Properties->SetObjectField(TEXT("diagnostics"), DiagnosticArray);
+
 	Schema->SetObjectField(TEXT("properties"), Properties);
 
 	TArray<TSharedPtr<FJsonValue>> Required;
@@ -95,27 +235,66 @@ TSharedRef<FJsonObject> UEMCPServerMcpSchema::BuildLiveCodingOutputSchema()
 
 void UEMCPServerMcpSchema::PopulateToolsList(TArray<TSharedPtr<FJsonValue>>& OutTools)
 {
-	TSharedRef<FJsonObject> CompileTool = MakeShared<FJsonObject>();
-	CompileTool->SetStringField(TEXT("name"), UEMCPServer::Mcp::CompileToolName);
-	CompileTool->SetStringField(TEXT("description"), TEXT("Trigger a UE Live Coding compile and return the latest compile snapshot."));
-	CompileTool->SetObjectField(TEXT("inputSchema"), BuildToolInputSchema(true));
-	CompileTool->SetObjectField(TEXT("outputSchema"), BuildLiveCodingOutputSchema());
-	TSharedPtr<FJsonObject> CompileAnnotations = MakeShared<FJsonObject>();
-	CompileAnnotations->SetBoolField(TEXT("destructiveHint"), false);
-	CompileAnnotations->SetBoolField(TEXT("readOnlyHint"), false);
-	CompileAnnotations->SetStringField(TEXT("title"), TEXT("Trigger Live Coding Compile"));
-	CompileTool->SetObjectField(TEXT("annotations"), CompileAnnotations);
-	OutTools.Add(MakeShared<FJsonValueObject>(CompileTool));
-
-	TSharedRef<FJsonObject> StatusTool = MakeShared<FJsonObject>();
-	StatusTool->SetStringField(TEXT("name"), UEMCPServer::Mcp::StatusToolName);
-	StatusTool->SetStringField(TEXT("description"), TEXT("Return the most recent Live Coding compile snapshot without starting a new compile."));
-	StatusTool->SetObjectField(TEXT("inputSchema"), BuildToolInputSchema(false));
-	StatusTool->SetObjectField(TEXT("outputSchema"), BuildLiveCodingOutputSchema());
-	TSharedPtr<FJsonObject> StatusAnnotations = MakeShared<FJsonObject>();
-	StatusAnnotations->SetBoolField(TEXT("destructiveHint"), false);
-	StatusAnnotations->SetBoolField(TEXT("readOnlyHint"), true);
-	StatusAnnotations->SetStringField(TEXT("title"), TEXT("Get Live Coding Status"));
-	StatusTool->SetObjectField(TEXT("annotations"), StatusAnnotations);
-	OutTools.Add(MakeShared<FJsonValueObject>(StatusTool));
+	for (const FUEMCPServerToolRef& Tool : FUEMCPServerToolRegistry::Get().GetTools())
+	{
+		TSharedRef<FJsonObject> ToolObject = MakeShared<FJsonObject>();
+		ToolObject->SetStringField(TEXT("name"), Tool->Name);
+		ToolObject->SetStringField(TEXT("description"), Tool->Description);
+		ToolObject->SetObjectField(TEXT("inputSchema"), Tool->InputSchema.IsValid() ? Tool->InputSchema : BuildToolInputSchema(false));
+		if (Tool->OutputSchema.IsValid())
+		{
+			ToolObject->SetObjectField(TEXT("outputSchema"), Tool->OutputSchema);
+		}
+
+		TSharedPtr<FJsonObject> Annotations = MakeShared<FJsonObject>();
+		Annotations->SetBoolField(TEXT("destructiveHint"), Tool->bDestructiveHint);
+		Annotations->SetBoolField(TEXT("readOnlyHint"), Tool->bReadOnlyHint);
+		if (!Tool->Title.IsEmpty())
+		{
+			Annotations->SetStringField(TEXT("title"), Tool->Title);
+		}
+		ToolObject->SetObjectField(TEXT("annotations"), Annotations);
+		OutTools.Add(MakeShared<FJsonValueObject>(ToolObject));
+	}
+}
+
+TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> UEMCPServerMcpSchema::GetSerializedToolsList()
+{
+	FToolsListCache& Cache = GetToolsListCache();
+	FScopeLock Guard(&Cache.Mutex);
+	if (!Cache.Serialized.IsValid())
+	{
+		FSerializedToolsList Serialized = SerializeToolsList();
+		Cache.Crc = FCrc::MemCrc32(Serialized->GetData(), Serialized->Num());
+		Cache.Serialized = Serialized;
+	}
+	return Cache.Serialized.ToSharedRef();
+}
+
+void UEMCPServerMcpSchema::InvalidateToolsList()
+{
+	FToolsListCache& Cache = GetToolsListCache();
+	bool bChanged = false;
+	{
+		FScopeLock Guard(&Cache.Mutex);
+		FSerializedToolsList Serialized = SerializeToolsList();
+		const uint32 NewCrc = FCrc::MemCrc32(Serialized->GetData(), Serialized->Num());
+		bChanged = !Cache.Serialized.IsValid() || NewCrc != Cache.Crc || Serialized->Num() != Cache.Serialized->Num();
+		if (bChanged)
+		{
+			Cache.Serialized = Serialized;
+			Cache.Crc = NewCrc;
+		}
+	}
+
+	if (bChanged)
+	{
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP tools list changed; notifying clients."));
+		Cache.OnChanged.Broadcast();
+	}
+}
+
+FSimpleMulticastDelegate& UEMCPServerMcpSchema::OnToolsListChanged()
+{
+	return GetToolsListCache().OnChanged;
 }
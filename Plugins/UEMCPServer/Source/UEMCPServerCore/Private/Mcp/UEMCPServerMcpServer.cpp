@@ -1,7 +1,15 @@
 #include "Mcp/UEMCPServerMcpServer.h"
 
+#include "Mcp/UEMCPServerJsonWriter.h"
+#include "Mcp/UEMCPServerMcpMessage.h"
+#include "Mcp/UEMCPServerMcpSchema.h"
 #include "Mcp/UEMCPServerMcpSession.h"
+#include "Mcp/UEMCPServerRequestTrace.h"
+#include "Mcp/UEMCPServerResponseCompression.h"
+#include "Mcp/UEMCPServerLiveCodingTools.h"
+#include "Mcp/UEMCPServerToolRegistry.h"
 #include "IUEMCPServerLiveCodingProvider.h"
+#include "UEMCPServerLiveCodingTypes.h"
 #include "UEMCPServerLog.h"
 
 #include "HttpPath.h"
@@ -10,10 +18,16 @@
 #include "HttpServerRequest.h"
 #include "HttpServerResponse.h"
 #include "IHttpRouter.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Dom/JsonObject.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "Containers/StringConv.h"
 #include "Templates/UniquePtr.h"
 #include "Misc/ConfigCacheIni.h"
 #include "Misc/ScopeLock.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 #include "Serialization/JsonReader.h"
 #include "Serialization/JsonSerializer.h"
 
@@ -22,28 +36,218 @@ namespace UEMCPServer
 	static constexpr const TCHAR* DefaultMcpEndpointPath = TEXT("/mcp");
 	static constexpr const TCHAR* ProtocolVersionHeader = TEXT("MCP-Protocol-Version");
 	static constexpr const TCHAR* SessionIdHeader = TEXT("Mcp-Session-Id");
-	static constexpr const TCHAR* AcceptHeader = TEXT("accept");
 	static constexpr const TCHAR* ContentTypeJson = TEXT("application/json");
-	static constexpr const TCHAR* ContentTypeEventStream = TEXT("text/event-stream");
 	static constexpr const TCHAR* ContentTypeEventStreamResponse = TEXT("text/event-stream");
 	static constexpr const TCHAR* CacheControlHeader = TEXT("cache-control");
+	static constexpr const TCHAR* RetryAfterHeader = TEXT("retry-after");
 	static constexpr const TCHAR* NoStoreValue = TEXT("no-store");
 	static constexpr const TCHAR* HttpListenersSection = TEXT("HTTPServer.Listeners");
 	static constexpr const TCHAR* ListenerOverridesKey = TEXT("ListenerOverrides");
 	static constexpr const TCHAR* ProtocolVersionValue = TEXT("2025-06-18");
+	static constexpr const TCHAR* ToolsListChangedNotification = TEXT("notifications/tools/list_changed");
+	static constexpr double EventStreamHeartbeatSeconds = 15.0;
+
+	/** Every GET stream ends after one batch, so clients are told to reconnect at once rather than after ~3 s. */
+	static constexpr int32 EventStreamRetryMilliseconds = 0;
+	static constexpr float SessionTickInterval = 1.0f;
+	static constexpr double StopDrainTimeoutSeconds = 5.0;
+	static constexpr const TCHAR* MetricsToolName = TEXT("server_metrics");
+	static constexpr const TCHAR* TraceToolName = TEXT("server_trace");
+	static constexpr int32 DefaultTraceLimit = 50;
 }
 
 #include "Mcp/UEMCPServerHttpUtils.h"
 
 namespace
 {
+	const TCHAR* SessionSourceToString(EUEMCPServerSessionSource Source)
+	{
+		switch (Source)
+		{
+		case EUEMCPServerSessionSource::Header:
+			return TEXT("header");
+		case EUEMCPServerSessionSource::Endpoint:
+			return TEXT("endpoint");
+		case EUEMCPServerSessionSource::Default:
+			return TEXT("default");
+		case EUEMCPServerSessionSource::Created:
+			return TEXT("new");
+		default:
+			return TEXT("no");
+		}
+	}
+
+	void AddMcpHeaders(FHttpServerResponse& Response, const FGuid& SessionId)
+	{
+		Response.Headers.Add(UEMCPServer::CacheControlHeader, { UEMCPServer::NoStoreValue });
+		if (SessionId.IsValid())
+		{
+			Response.Headers.Add(UEMCPServer::SessionIdHeader, { SessionId.ToString(EGuidFormats::DigitsWithHyphens) });
+		}
+		Response.Headers.Add(UEMCPServer::ProtocolVersionHeader, { UEMCPServer::ProtocolVersionValue });
+	}
+
+	void CompleteEventStream(const FHttpResultCallback& OnComplete, const FGuid& SessionId, const TArray<FUEMCPServerSseEvent>& Events)
+	{
+		TArray<uint8> SseBody;
+		if (Events.IsEmpty())
+		{
+			UEMCPServerHttpUtils::AppendSseRetry(SseBody, UEMCPServer::EventStreamRetryMilliseconds);
+			UEMCPServerHttpUtils::AppendSseComment(SseBody, ANSITEXTVIEW("keep-alive"));
+		}
+		else
+		{
+			int32 TotalBytes = UEMCPServerHttpUtils::SseEventOverhead;
+			for (const FUEMCPServerSseEvent& Event : Events)
+			{
+				TotalBytes += Event.Payload->Num() + UEMCPServerHttpUtils::SseEventOverhead;
+			}
+			SseBody.Reserve(TotalBytes);
+
+			UEMCPServerHttpUtils::AppendSseRetry(SseBody, UEMCPServer::EventStreamRetryMilliseconds);
+
+			for (const FUEMCPServerSseEvent& Event : Events)
+			{
+				UEMCPServerHttpUtils::AppendSseEvent(SseBody, *Event.Payload, Event.Id);
+			}
+		}
+
+		TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(MoveTemp(SseBody), UEMCPServer::ContentTypeEventStreamResponse);
+		AddMcpHeaders(*Response, SessionId);
+		OnComplete(MoveTemp(Response));
+	}
+
+	const TCHAR* AdmissionToString(EUEMCPServerAdmission Admission)
+	{
+		switch (Admission)
+		{
+		case EUEMCPServerAdmission::TooManyInFlight:
+			return TEXT("too many requests in flight");
+		case EUEMCPServerAdmission::SessionRateLimited:
+			return TEXT("session rate limit");
+		case EUEMCPServerAdmission::GlobalRateLimited:
+			return TEXT("global rate limit");
+		default:
+			return TEXT("admitted");
+		}
+	}
+
+	TUniquePtr<FHttpServerResponse> CreateTooManyRequestsResponse(EUEMCPServerAdmission Admission, double RetryAfterSeconds, const FGuid& SessionId)
+	{
+		TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Error(EHttpServerResponseCodes::TooManyRequests, TEXT("rate_limited"),
+			FString::Printf(TEXT("Request rejected: %s."), AdmissionToString(Admission)));
+		Response->Headers.Add(UEMCPServer::RetryAfterHeader, { FString::FromInt(FMath::Max(1, FMath::CeilToInt(RetryAfterSeconds))) });
+		AddMcpHeaders(*Response, SessionId);
+		return Response;
+	}
+
+	using FTraceBufferRef = TSharedRef<FUEMCPServerRequestTraceBuffer, ESPMode::ThreadSafe>;
+
+	/** Completes an HTTP request and records its trace; the connection may only be completed from the game thread. */
+	void CompleteRequest(const FTraceBufferRef& TraceBuffer, FUEMCPServerRequestTrace Trace, const FHttpResultCallback& OnComplete, TUniquePtr<FHttpServerResponse>&& Response)
+	{
+		Trace.StatusCode = static_cast<int32>(Response->Code);
+		Trace.ResponseBytes = Response->Body.Num();
+		Trace.MarkPhase(EUEMCPServerRequestPhase::Serialized);
+
+		auto Complete = [TraceBuffer, Trace, OnComplete, Response = MoveTemp(Response)]() mutable
+		{
+			OnComplete(MoveTemp(Response));
+			Trace.MarkPhase(EUEMCPServerRequestPhase::Completed);
+			TraceBuffer->Record(Trace);
+		};
+
+		if (IsInGameThread())
+		{
+			Complete();
+			return;
+		}
+		AsyncTask(ENamedThreads::GameThread, MoveTemp(Complete));
+	}
+
+	void FlushEventStream(const TSharedPtr<FUEMCPServerMcpSession>& Session, bool bForce)
+	{
+		if (!Session.IsValid())
+		{
+			return;
+		}
+
+		FHttpResultCallback OnComplete;
+		TArray<FUEMCPServerSseEvent> Events;
+		if (!Session->TryDetachEventStream(bForce, UEMCPServer::EventStreamHeartbeatSeconds, OnComplete, Events))
+		{
+			return;
+		}
+
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP session %s event stream flushed (%d event(s))."),
+			*Session->GetClientId().ToString(EGuidFormats::DigitsWithHyphens), Events.Num());
+		CompleteEventStream(OnComplete, Session->GetClientId(), Events);
+	}
+
+	/** Ends the session's event stream and drops its state after it left the session table. Game thread only. */
+	void CloseSession(const TSharedPtr<FUEMCPServerMcpSession>& Session, FUEMCPServerAdmissionControl& AdmissionControl)
+	{
+		if (Session.IsValid())
+		{
+			FlushEventStream(Session, /*bForce=*/true);
+			Session->HandleClosed();
+			AdmissionControl.ForgetSession(Session->GetClientId());
+		}
+	}
+
+	/** Turns the replies of one POST payload into 202, a JSON body or an SSE body, depending on what the client accepts. */
+	TUniquePtr<FHttpServerResponse> CreatePostResponse(FUEMCPServerMcpReplies&& Replies, const FUEMCPServerRequestTrace& Trace, bool bIsBatch, const FUEMCPServerAcceptPreferences& Accept)
+	{
+		if (Replies.IsEmpty())
+		{
+			TUniquePtr<FHttpServerResponse> AcceptedResponse = MakeUnique<FHttpServerResponse>();
+			AcceptedResponse->Code = EHttpServerResponseCodes::Accepted;
+			AddMcpHeaders(*AcceptedResponse, Trace.SessionId);
+			UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> returning 202 Accepted"), *Trace.Describe());
+			return AcceptedResponse;
+		}
 
+		const int32 ReplyCount = Replies.Num();
+		const bool bCanUseJson = ReplyCount == 1 || bIsBatch;
+		if (Accept.AcceptsJson() && bCanUseJson && (!Accept.AcceptsEventStream() || Accept.GetPreferred() == EUEMCPServerRepresentation::Json))
+		{
+			// A single reply is the whole buffer, so it is handed to the response without a copy.
+			TArray<uint8> JsonBody = bIsBatch ? Replies.ToJsonArray() : MoveTemp(Replies.Buffer);
+			TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(MoveTemp(JsonBody), UEMCPServer::ContentTypeJson);
+			AddMcpHeaders(*Response, Trace.SessionId);
+			UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> returning JSON response (%d message(s))"), *Trace.Describe(), ReplyCount);
+			return Response;
+		}
+
+		if (!Accept.AcceptsEventStream())
+		{
+			UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: SSE required for multi-message response"), *Trace.Describe());
+			return FHttpServerResponse::Error(EHttpServerResponseCodes::NoneAcceptable, TEXT("sse_required"), TEXT("Client must accept text/event-stream for multi-message responses."));
+		}
+
+		TArray<uint8> SseBody;
+		SseBody.Reserve(Replies.Buffer.Num() + ReplyCount * UEMCPServerHttpUtils::SseEventOverhead);
+		for (int32 Index = 0; Index < ReplyCount; ++Index)
+		{
+			UEMCPServerHttpUtils::AppendSseEvent(SseBody, Replies.GetReply(Index));
+		}
+
+		TUniquePtr<FHttpServerResponse> SseResponse = FHttpServerResponse::Create(MoveTemp(SseBody), UEMCPServer::ContentTypeEventStreamResponse);
+		AddMcpHeaders(*SseResponse, Trace.SessionId);
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> returning SSE (%d message(s))"), *Trace.Describe(), ReplyCount);
+		return SseResponse;
+	}
 }
 
-FUEMCPServerMcpServer::FUEMCPServerMcpServer(IUEMCPServerLiveCodingProvider& InLiveCodingManager, uint32 InPort, const FString& InBindAddress)
+FUEMCPServerMcpServer::FUEMCPServerMcpServer(IUEMCPServerLiveCodingProvider& InLiveCodingManager, const FUEMCPServerMcpServerSettings& InSettings)
 	: LiveCodingManager(InLiveCodingManager)
-	, Port(InPort)
-	, BindAddress(InBindAddress)
+	, Settings(InSettings)
+	, SessionTable(InSettings.SessionIdleTimeoutSeconds, InSettings.MaxSessions)
+	, AdmissionControl(MakeShared<FUEMCPServerAdmissionControl, ESPMode::ThreadSafe>(InSettings))
+	, Compression(MakeShared<FUEMCPServerResponseCompression, ESPMode::ThreadSafe>(InSettings))
+	, TraceBuffer(MakeShared<FUEMCPServerRequestTraceBuffer, ESPMode::ThreadSafe>())
+	, UnboundRequestQueue(MakeShared<FUEMCPServerSerialQueue, ESPMode::ThreadSafe>())
+	, InFlightPosts(MakeShared<TAtomic<int32>, ESPMode::ThreadSafe>(0))
 	, EndpointPath(UEMCPServer::DefaultMcpEndpointPath)
 	, bListenersStarted(false)
 {
@@ -64,10 +268,10 @@ bool FUEMCPServerMcpServer::Start()
 	SetSessionOverrideConfig();
 
 	FHttpServerModule& HttpModule = FHttpServerModule::Get();
-	Router = HttpModule.GetHttpRouter(Port, /*bFailOnBindFailure=*/true);
+	Router = HttpModule.GetHttpRouter(Settings.Port, /*bFailOnBindFailure=*/true);
 	if (!Router.IsValid())
 	{
-		UE_LOG(LogUEMCPServer, Error, TEXT("Unable to start MCP HTTP server on %s:%u"), BindAddress.IsEmpty() ? TEXT("0.0.0.0") : *BindAddress, Port);
+		UE_LOG(LogUEMCPServer, Error, TEXT("Unable to start MCP HTTP server on %s:%u"), Settings.BindAddress.IsEmpty() ? TEXT("0.0.0.0") : *Settings.BindAddress, Settings.Port);
 		return false;
 	}
 
@@ -98,15 +302,38 @@ bool FUEMCPServerMcpServer::Start()
 		return false;
 	}
 
+	DeleteRouteHandle = Router->BindRoute(
+		EndpointPathObject,
+		EHttpServerRequestVerbs::VERB_DELETE,
+		FHttpRequestHandler::CreateRaw(this, &FUEMCPServerMcpServer::HandleDeleteRequest));
+
+	if (!DeleteRouteHandle.IsValid())
+	{
+		UE_LOG(LogUEMCPServer, Error, TEXT("Failed to bind MCP DELETE handler at %s"), *EndpointPathObject.GetPath());
+		Router->UnbindRoute(PostRouteHandle);
+		Router->UnbindRoute(GetRouteHandle);
+		Router.Reset();
+		return false;
+	}
+
 	if (!bListenersStarted)
 	{
 		HttpModule.StartAllListeners();
 		bListenersStarted = true;
 	}
 
+	SessionTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FUEMCPServerMcpServer::TickSessions),
+		UEMCPServer::SessionTickInterval);
+	CompileFinishedHandle = LiveCodingManager.OnCompileFinished().AddRaw(this, &FUEMCPServerMcpServer::HandleCompileFinished);
+	CompileLogHandle = LiveCodingManager.OnCompileLog().AddRaw(this, &FUEMCPServerMcpServer::HandleCompileLog);
+	ToolsListChangedHandle = UEMCPServerMcpSchema::OnToolsListChanged().AddRaw(this, &FUEMCPServerMcpServer::HandleToolsListChanged);
+	UEMCPServerLiveCodingTools::Register(FUEMCPServerToolRegistry::Get(), LiveCodingManager, Settings);
+	RegisterServerTools();
+
 	UE_LOG(LogUEMCPServer, Display, TEXT("UEMCPServer MCP server listening on http://%s:%u%s"),
-		BindAddress.IsEmpty() ? TEXT("127.0.0.1") : *BindAddress,
-		Port,
+		Settings.BindAddress.IsEmpty() ? TEXT("127.0.0.1") : *Settings.BindAddress,
+		Settings.Port,
 		*EndpointPathObject.GetPath());
 
 	return true;
@@ -114,6 +341,37 @@ bool FUEMCPServerMcpServer::Start()
 
 void FUEMCPServerMcpServer::Stop()
 {
+	// Unsubscribe first: unregistering the tools below changes the list, and sessions must not be told about it.
+	if (ToolsListChangedHandle.IsValid())
+	{
+		UEMCPServerMcpSchema::OnToolsListChanged().Remove(ToolsListChangedHandle);
+		ToolsListChangedHandle.Reset();
+	}
+
+	if (CompileFinishedHandle.IsValid())
+	{
+		LiveCodingManager.OnCompileFinished().Remove(CompileFinishedHandle);
+		CompileFinishedHandle.Reset();
+	}
+
+	if (CompileLogHandle.IsValid())
+	{
+		LiveCodingManager.OnCompileLog().Remove(CompileLogHandle);
+		CompileLogHandle.Reset();
+	}
+
+	if (SessionTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(SessionTickerHandle);
+		SessionTickerHandle.Reset();
+	}
+
+	// Close parked event streams while the listeners can still deliver the response.
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Session : SessionTable.GetSessions())
+	{
+		FlushEventStream(Session, /*bForce=*/true);
+	}
+
 	if (Router.IsValid())
 	{
 		if (PostRouteHandle.IsValid())
@@ -127,8 +385,38 @@ void FUEMCPServerMcpServer::Stop()
 			Router->UnbindRoute(GetRouteHandle);
 			GetRouteHandle = FHttpRouteHandle();
 		}
+
+		if (DeleteRouteHandle.IsValid())
+		{
+			Router->UnbindRoute(DeleteRouteHandle);
+			DeleteRouteHandle = FHttpRouteHandle();
+		}
+	}
+
+	// Admitted requests still use the session table and the tool registry, and reply through the listeners. Their
+	// tool hops and responses complete on the game thread, so keep it pumping; compile waits are answered now rather
+	// than at their timeout. A request that is still stuck after the bound is abandoned so shutdown cannot hang.
+	const double DrainDeadline = FPlatformTime::Seconds() + UEMCPServer::StopDrainTimeoutSeconds;
+	while (InFlightPosts->Load() > 0 && FPlatformTime::Seconds() < DrainDeadline)
+	{
+		if (IsInGameThread())
+		{
+			UEMCPServerLiveCodingTools::CancelWaits();
+			FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		}
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	if (const int32 Abandoned = InFlightPosts->Load())
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Stopping with %d MCP request(s) still unanswered; their responses will be dropped."), Abandoned);
 	}
 
+	// Requests are answered (or abandoned), so none can look tools up any more; the listeners are still up for any
+	// waiter that started after the loop.
+	UEMCPServerLiveCodingTools::Unregister(FUEMCPServerToolRegistry::Get());
+	UnregisterServerTools();
+
 	FHttpServerModule& HttpModule = FHttpServerModule::Get();
 	if (bListenersStarted)
 	{
@@ -138,219 +426,225 @@ void FUEMCPServerMcpServer::Stop()
 
 	Router.Reset();
 
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Session : SessionTable.RemoveAll())
 	{
-		FScopeLock Guard(&SessionMutex);
-		for (auto& SessionPair : Sessions)
-		{
-			if (SessionPair.Value.IsValid())
-			{
-				SessionPair.Value->HandleClosed();
-			}
-		}
-		Sessions.Empty();
-		EndpointToSession.Empty();
+		CloseSession(Session, *AdmissionControl);
 	}
 }
 
 bool FUEMCPServerMcpServer::HandlePostRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
 {
-	const FString Body = UEMCPServerHttpUtils::RequestBodyToString(Request);
-	if (Body.IsEmpty())
+	TUniquePtr<FPendingPost> Post = MakeUnique<FPendingPost>();
+	Post->Trace.RequestId = TraceBuffer->NextRequestId();
+	Post->Trace.RequestBytes = Request.Body.Num();
+	Post->Trace.MarkPhase(EUEMCPServerRequestPhase::Received);
+
+	const FUEMCPServerRequestHeaders Headers(Request.Headers);
+	const FString Endpoint = UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress);
+
+	if (Request.Body.IsEmpty())
 	{
 		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: empty body"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress), FGuid(), FString(), UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::AcceptHeader)));
-		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("empty_body"), TEXT("Request body is required.")));
+			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, FGuid(), FString(), Headers.GetAccept()));
+		CompleteRequest(TraceBuffer, Post->Trace, OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("empty_body"), TEXT("Request body is required.")));
 		return true;
 	}
 
-	const FString ProtocolVersionHeaderValue = UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::ProtocolVersionHeader);
-	if (!ValidateProtocolVersion(ProtocolVersionHeaderValue))
+	if (!ValidateProtocolVersion(Headers.GetProtocolVersion()))
 	{
 		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: unsupported protocol %s"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress), FGuid(), FString(), UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::AcceptHeader)),
-			*ProtocolVersionHeaderValue);
-		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("invalid_protocol_version"), TEXT("Unsupported MCP protocol version.")));
+			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, FGuid(), FString(), Headers.GetAccept()),
+			*Headers.GetProtocolVersion());
+		CompleteRequest(TraceBuffer, Post->Trace, OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("invalid_protocol_version"), TEXT("Unsupported MCP protocol version.")));
 		return true;
 	}
 
-	TSharedPtr<FJsonObject> JsonObject = UEMCPServerHttpUtils::ParseJsonObject(Body);
-	if (!JsonObject.IsValid())
+	Post->Endpoint = Endpoint;
+	Post->AcceptHeaderValue = Headers.GetAccept();
+	Post->Accept = UEMCPServerHttpUtils::NegotiateAccept(Post->AcceptHeaderValue);
+	Post->Encoding = FUEMCPServerResponseCompression::NegotiateEncoding(Headers.GetAcceptEncoding());
+	if (Post->Accept.GetPreferred() == EUEMCPServerRepresentation::None)
 	{
-		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: invalid JSON"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress), FGuid(), FString(), UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::AcceptHeader)));
-		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("invalid_json"), TEXT("Failed to parse JSON-RPC payload.")));
+		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: unsupported Accept"),
+			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Post->Endpoint, FGuid(), FString(), Post->AcceptHeaderValue));
+		CompleteRequest(TraceBuffer, Post->Trace, OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::NoneAcceptable, TEXT("unsupported_accept"), TEXT("Client must accept application/json or text/event-stream.")));
 		return true;
 	}
 
-	const FString AcceptHeaderValue = UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::AcceptHeader);
-	const bool bClientAcceptsJson = AcceptHeaderValue.IsEmpty() || UEMCPServerHttpUtils::ContainsToken(AcceptHeaderValue, UEMCPServer::ContentTypeJson);
-	const bool bClientAcceptsSse = UEMCPServerHttpUtils::ContainsToken(AcceptHeaderValue, UEMCPServer::ContentTypeEventStream);
-	if (!bClientAcceptsJson && !bClientAcceptsSse)
+	Post->bHasSessionHeader = UEMCPServerHttpUtils::TryParseSessionId(Headers.GetSessionId(), Post->SessionId);
+
+	// Bind the request to its session now so the session's queue fixes the processing order; only requests that may
+	// create a session (initialize from a new client) go through the shared unbound queue.
+	FUEMCPServerSessionLookup Lookup = SessionTable.ResolveSession(Post->bHasSessionHeader ? &Post->SessionId : nullptr, Post->Endpoint, /*bAllowCreate=*/false);
+	if (!Lookup.Session.IsValid() && Post->bHasSessionHeader)
 	{
-		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: unsupported Accept"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress), FGuid(), FString(), AcceptHeaderValue));
-		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::NoneAcceptable, TEXT("unsupported_accept"), TEXT("Client must accept application/json or text/event-stream.")));
+		Post->Trace.SessionId = Post->SessionId;
+		CompleteRequest(TraceBuffer, Post->Trace, OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound, TEXT("unknown_session"), TEXT("MCP session not found.")));
 		return true;
 	}
 
-	const FString Endpoint = UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress);
+	// Admit before the body is copied and queued, so a flooding client costs neither memory nor a parse.
+	const FGuid AdmissionSessionId = Lookup.Session.IsValid() ? Lookup.SessionId : FGuid();
+	double RetryAfterSeconds = 0.0;
+	const EUEMCPServerAdmission Admission = AdmissionControl->TryAdmit(AdmissionSessionId, RetryAfterSeconds);
+	if (Admission != EUEMCPServerAdmission::Admitted)
+	{
+		Post->Trace.SessionId = AdmissionSessionId;
+		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: %s (retry after %.1fs)"), *Post->Trace.Describe(), AdmissionToString(Admission), RetryAfterSeconds);
+		CompleteRequest(TraceBuffer, Post->Trace, OnComplete, CreateTooManyRequestsResponse(Admission, RetryAfterSeconds, AdmissionSessionId));
+		return true;
+	}
 
-	FGuid SessionId;
-	const FString SessionIdHeaderValue = UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::SessionIdHeader);
-	const bool bHasSessionHeader = UEMCPServerHttpUtils::TryParseSessionId(SessionIdHeaderValue, SessionId);
+	// Counted until the response is delivered, not merely until the worker is done with it.
+	InFlightPosts->IncrementExchange();
+	Post->OnComplete = [OnComplete, InFlight = InFlightPosts](TUniquePtr<FHttpServerResponse>&& Response)
+	{
+		OnComplete(MoveTemp(Response));
+		InFlight->DecrementExchange();
+	};
+	Post->Body = Request.Body;
+	Post->Session = Lookup.Session;
+	Post->SessionId = Lookup.Session.IsValid() ? Lookup.SessionId : Post->SessionId;
+	Post->Source = Lookup.Source;
+
+	TUniqueFunction<void(FUEMCPServerSerialQueue::FOnWorkDone&&)> Work = [this, Post = MoveTemp(Post)](FUEMCPServerSerialQueue::FOnWorkDone&& OnDone)
+	{
+		ProcessPostRequest(*Post, MoveTemp(OnDone));
+	};
 
-	bool bIsInitializeRequest = false;
-	FString Method;
-	if (JsonObject->TryGetStringField(TEXT("method"), Method))
+	if (Lookup.Session.IsValid())
 	{
-		bIsInitializeRequest = Method.Equals(TEXT("initialize"), ESearchCase::CaseSensitive);
+		Lookup.Session->EnqueueRequest(MoveTemp(Work));
 	}
+	else
+	{
+		UnboundRequestQueue->EnqueueAsync(MoveTemp(Work));
+	}
+	return true;
+}
 
-	UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP POST %s from %s (Accept=%s, HasSessionHeader=%s)"),
-		Method.IsEmpty() ? TEXT("<response>") : *Method,
-		Endpoint.IsEmpty() ? TEXT("unknown") : *Endpoint,
-		AcceptHeaderValue.IsEmpty() ? TEXT("<none>") : *AcceptHeaderValue,
-		bHasSessionHeader ? TEXT("true") : TEXT("false"));
+void FUEMCPServerMcpServer::ProcessPostRequest(FPendingPost& Post, FUEMCPServerSerialQueue::FOnWorkDone&& OnDone)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UEMCPServer_ProcessPostRequest);
+
+	FUEMCPServerRequestTrace& Trace = Post.Trace;
+	Trace.SessionId = Post.SessionId;
 
-	TSharedPtr<FUEMCPServerMcpSession> Session;
-	if (bHasSessionHeader)
+	FUEMCPServerMcpPayload Payload;
+	if (!UEMCPServerHttpUtils::ParseMcpPayload(Post.Body, Payload))
 	{
-		Session = FindSessionById(SessionId);
-		if (!Session.IsValid())
-		{
-			OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound, TEXT("unknown_session"), TEXT("MCP session not found.")));
-			return true;
-		}
-		AssociateEndpointWithSession(Endpoint, SessionId);
-		UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> using header session"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
+		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: invalid JSON"),
+			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Post.Endpoint, FGuid(), FString(), Post.AcceptHeaderValue));
+		AdmissionControl->Release();
+		OnDone();
+		CompleteRequest(TraceBuffer, Trace, Post.OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("invalid_json"), TEXT("Failed to parse JSON-RPC payload.")));
+		return;
 	}
-	else if (bIsInitializeRequest)
+
+	const bool bIsInitializeRequest = Payload.ContainsMethod(TEXT("initialize"));
+	const FString Method = Payload.bIsBatch
+		? FString::Printf(TEXT("batch[%d]"), Payload.Messages.Num())
+		: Payload.Messages[0].Method;
+	Trace.SetMethod(Method);
+	Trace.MessageCount = Payload.Messages.Num();
+	Trace.MarkPhase(EUEMCPServerRequestPhase::Parsed);
+
+	UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP POST #%llu %s from %s (Accept=%s, HasSessionHeader=%s)"),
+		Trace.RequestId,
+		Method.IsEmpty() ? TEXT("<response>") : *Method,
+		Post.Endpoint.IsEmpty() ? TEXT("unknown") : *Post.Endpoint,
+		Post.AcceptHeaderValue.IsEmpty() ? TEXT("<none>") : *Post.AcceptHeaderValue,
+		Post.bHasSessionHeader ? TEXT("true") : TEXT("false"));
+
+	TSharedPtr<FUEMCPServerMcpSession> Session = Post.Session;
+	if (!Session.IsValid())
 	{
-		Session = FindSessionForEndpoint(Endpoint, SessionId);
-		if (Session.IsValid())
+		FUEMCPServerSessionLookup Lookup = SessionTable.ResolveSession(nullptr, Post.Endpoint, /*bAllowCreate=*/bIsInitializeRequest);
+		if (!Lookup.Evicted.IsEmpty())
 		{
-			UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> initialize reuse endpoint session"),
-				*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-		}
-		if (!Session.IsValid())
-		{
-			Session = FindDefaultSession(SessionId);
-			if (Session.IsValid())
+			AsyncTask(ENamedThreads::GameThread, [Evicted = MoveTemp(Lookup.Evicted), AdmissionControlRef = AdmissionControl]()
 			{
-				AssociateEndpointWithSession(Endpoint, SessionId);
-				UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> initialize reuse default session"),
-					*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-			}
+				for (const TSharedPtr<FUEMCPServerMcpSession>& EvictedSession : Evicted)
+				{
+					CloseSession(EvictedSession, *AdmissionControlRef);
+				}
+			});
 		}
 
-		if (!Session.IsValid())
-		{
-			Session = CreateSession(Endpoint, SessionId);
-		}
-	}
-	else
-	{
-		Session = FindSessionForEndpoint(Endpoint, SessionId);
-		if (Session.IsValid())
-		{
-			UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> reuse endpoint session"),
-				*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-		}
-		if (!Session.IsValid())
+		if (Lookup.bSessionLimitReached)
 		{
-			Session = FindDefaultSession(SessionId);
-			if (Session.IsValid())
-			{
-				AssociateEndpointWithSession(Endpoint, SessionId);
-				UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> request reuse default session"),
-					*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-			}
+			AdmissionControl->Release();
+			OnDone();
+			CompleteRequest(TraceBuffer, Trace, Post.OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::ServiceUnavail, TEXT("session_limit"), TEXT("MCP session limit reached; every session has an open event stream.")));
+			return;
 		}
 
-		if (!Session.IsValid())
+		if (!Lookup.Session.IsValid())
 		{
 			UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: session missing"),
-				*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-			OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("missing_session"), TEXT("Mcp-Session-Id header is required.")));
-			return true;
+				*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Post.Endpoint, Post.SessionId, Method, Post.AcceptHeaderValue));
+			AdmissionControl->Release();
+			OnDone();
+			CompleteRequest(TraceBuffer, Trace, Post.OnComplete, FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("missing_session"), TEXT("Mcp-Session-Id header is required.")));
+			return;
 		}
-	}
 
-	TArray<FString> PendingMessages;
-	if (!Session->HandleMessage(Body, PendingMessages))
-	{
-		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> session processing error"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServerError, TEXT("session_error"), TEXT("Failed to process MCP message.")));
-		return true;
+		Session = Lookup.Session;
+		Post.SessionId = Lookup.SessionId;
+		Post.Source = Lookup.Source;
 	}
 
-	if (PendingMessages.IsEmpty())
-	{
-		TUniquePtr<FHttpServerResponse> AcceptedResponse = MakeUnique<FHttpServerResponse>();
-		AcceptedResponse->Code = EHttpServerResponseCodes::Accepted;
-		AcceptedResponse->Headers.Add(UEMCPServer::CacheControlHeader, { UEMCPServer::NoStoreValue });
-		if (SessionId.IsValid())
-		{
-			AcceptedResponse->Headers.Add(UEMCPServer::SessionIdHeader, { SessionId.ToString(EGuidFormats::DigitsWithHyphens) });
-		}
-		AcceptedResponse->Headers.Add(UEMCPServer::ProtocolVersionHeader, { UEMCPServer::ProtocolVersionValue });
-		UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> returning 202 Accepted"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-		OnComplete(MoveTemp(AcceptedResponse));
-		return true;
-	}
+	const FGuid SessionId = Post.SessionId;
+	Trace.SessionId = SessionId;
+	UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> %s session"), *Trace.Describe(), SessionSourceToString(Post.Source));
 
-	if (PendingMessages.Num() == 1 && bClientAcceptsJson)
+	double RetryAfterSeconds = 0.0;
+	const EUEMCPServerAdmission Admission = AdmissionControl->TryChargeMessages(SessionId, Payload.Messages.Num(), RetryAfterSeconds);
+	if (Admission != EUEMCPServerAdmission::Admitted)
 	{
-		TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(PendingMessages[0], UEMCPServer::ContentTypeJson);
-		Response->Headers.Add(UEMCPServer::CacheControlHeader, { UEMCPServer::NoStoreValue });
-		if (SessionId.IsValid())
-		{
-			Response->Headers.Add(UEMCPServer::SessionIdHeader, { SessionId.ToString(EGuidFormats::DigitsWithHyphens) });
-		}
-		Response->Headers.Add(UEMCPServer::ProtocolVersionHeader, { UEMCPServer::ProtocolVersionValue });
-		UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> returning JSON response"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-		OnComplete(MoveTemp(Response));
-		return true;
-	}
-
-	if (!bClientAcceptsSse)
-	{
-		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: SSE required for multi-message response"),
-			*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue));
-		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::NoneAcceptable, TEXT("sse_required"), TEXT("Client must accept text/event-stream for multi-message responses.")));
-		return true;
+		AdmissionControl->Release();
+		OnDone();
+		UE_LOG(LogUEMCPServer, Warning, TEXT("%s -> rejecting: %s (retry after %.1fs)"), *Trace.Describe(), AdmissionToString(Admission), RetryAfterSeconds);
+		CompleteRequest(TraceBuffer, Trace, Post.OnComplete, CreateTooManyRequestsResponse(Admission, RetryAfterSeconds, SessionId));
+		return;
 	}
 
-	FString SsePayload;
-	SsePayload.Reserve(PendingMessages.Num() * 64);
-	for (const FString& Message : PendingMessages)
+	const bool bIsBatch = Payload.bIsBatch;
+	const FUEMCPServerAcceptPreferences Accept = Post.Accept;
+	const EUEMCPServerContentEncoding Encoding = Post.Encoding;
+	Trace.MarkPhase(EUEMCPServerRequestPhase::Dispatched);
+	Session->HandlePayload(MoveTemp(Payload), [OnDone = MoveTemp(OnDone), OnComplete = Post.OnComplete, Trace, bIsBatch, Accept, Encoding, AdmissionControlRef = AdmissionControl, CompressionRef = Compression, TraceBufferRef = TraceBuffer](FUEMCPServerMcpReplies&& Replies) mutable
 	{
-		UEMCPServerHttpUtils::AppendSseEvent(SsePayload, Message);
-	}
+		// Every message is answered; the session's next request may start while this reply is serialized.
+		AdmissionControlRef->Release();
+		OnDone();
 
-	TUniquePtr<FHttpServerResponse> SseResponse = FHttpServerResponse::Create(SsePayload, UEMCPServer::ContentTypeEventStreamResponse);
-	SseResponse->Headers.Add(UEMCPServer::CacheControlHeader, { UEMCPServer::NoStoreValue });
-	if (SessionId.IsValid())
-	{
-		SseResponse->Headers.Add(UEMCPServer::SessionIdHeader, { SessionId.ToString(EGuidFormats::DigitsWithHyphens) });
-	}
-	SseResponse->Headers.Add(UEMCPServer::ProtocolVersionHeader, { UEMCPServer::ProtocolVersionValue });
-	UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> returning SSE (%d message(s))"),
-		*UEMCPServerHttpUtils::MakeLogContext(TEXT("POST"), Endpoint, SessionId, Method, AcceptHeaderValue),
-		PendingMessages.Num());
-	OnComplete(MoveTemp(SseResponse));
-	return true;
+		auto Respond = [OnComplete = MoveTemp(OnComplete), Trace, bIsBatch, Accept, Encoding, CompressionRef = MoveTemp(CompressionRef), TraceBufferRef = MoveTemp(TraceBufferRef), Replies = MoveTemp(Replies)]() mutable
+		{
+			TUniquePtr<FHttpServerResponse> Response = CreatePostResponse(MoveTemp(Replies), Trace, bIsBatch, Accept);
+			const int32 UncompressedBytes = Response->Body.Num();
+			Trace.CompressCycles = CompressionRef->CompressResponse(*Response, Encoding);
+			Trace.UncompressedResponseBytes = Response->Body.Num() != UncompressedBytes ? UncompressedBytes : 0;
+			CompleteRequest(TraceBufferRef, Trace, OnComplete, MoveTemp(Response));
+		};
+
+		// Deferred game-thread tools answer from the game thread; keep serializing and compressing a possibly
+		// large reply off it.
+		if (IsInGameThread())
+		{
+			AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, MoveTemp(Respond));
+			return;
+		}
+		Respond();
+	});
 }
 
 bool FUEMCPServerMcpServer::HandleGetRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
 {
+	const FUEMCPServerRequestHeaders Headers(Request.Headers);
+
 	FGuid SessionId;
-	const FString SessionIdHeaderValue = UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::SessionIdHeader);
-	bool bHasSession = UEMCPServerHttpUtils::TryParseSessionId(SessionIdHeaderValue, SessionId);
+	bool bHasSession = UEMCPServerHttpUtils::TryParseSessionId(Headers.GetSessionId(), SessionId);
 	if (!bHasSession)
 	{
 		if (const FString* QueryValue = Request.QueryParams.Find(TEXT("sessionId")))
@@ -363,96 +657,286 @@ bool FUEMCPServerMcpServer::HandleGetRequest(const FHttpServerRequest& Request,
 		}
 	}
 
-	TSharedPtr<FUEMCPServerMcpSession> Session;
 	const FString Endpoint = UEMCPServerHttpUtils::PeerEndpointString(Request.PeerAddress);
-	const FString AcceptHeaderValue = UEMCPServerHttpUtils::ExtractHeaderValue(Request.Headers, UEMCPServer::AcceptHeader);
 
+	FUEMCPServerSessionLookup Lookup;
 	if (bHasSession)
 	{
-		Session = FindSessionById(SessionId);
-		if (Session.IsValid())
-		{
-			AssociateEndpointWithSession(Endpoint, SessionId);
-			UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> GET SSE reuse session"),
-				*UEMCPServerHttpUtils::MakeLogContext(TEXT("GET"), Endpoint, SessionId, FString(), AcceptHeaderValue));
-		}
+		Lookup = SessionTable.ResolveSession(&SessionId, Endpoint, /*bAllowCreate=*/false);
+	}
+	if (!Lookup.Session.IsValid())
+	{
+		Lookup = SessionTable.ResolveSession(nullptr, Endpoint, /*bAllowCreate=*/true);
+	}
+
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Evicted : Lookup.Evicted)
+	{
+		CloseSession(Evicted, *AdmissionControl);
 	}
 
-	bool bCreatedSession = false;
+	if (Lookup.bSessionLimitReached)
+	{
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServiceUnavail, TEXT("session_limit"), TEXT("MCP session limit reached; every session has an open event stream.")));
+		return true;
+	}
+
+	const TSharedPtr<FUEMCPServerMcpSession>& Session = Lookup.Session;
+	SessionId = Lookup.SessionId;
+
+	// Event IDs are non-negative integers; anything else is ignored, so the client gets a full replay rather than a
+	// resume point guessed from a malformed header.
+	TOptional<int64> LastEventId;
+	int64 ParsedLastEventId = 0;
+	if (!Headers.GetLastEventId().IsEmpty()
+		&& LexTryParseString(ParsedLastEventId, *Headers.GetLastEventId())
+		&& ParsedLastEventId >= 0)
+	{
+		LastEventId = ParsedLastEventId;
+	}
+
+	const FHttpResultCallback Superseded = Session->AttachEventStream(OnComplete, LastEventId);
+	if (Superseded.IsSet())
+	{
+		// A newer GET replaces the parked one; end the old stream cleanly so the client is not left hanging.
+		CompleteEventStream(Superseded, SessionId, TArray<FUEMCPServerSseEvent>());
+	}
+
+	UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> GET SSE attached to %s session (Last-Event-ID=%s)"),
+		*UEMCPServerHttpUtils::MakeLogContext(TEXT("GET"), Endpoint, SessionId, FString(), Headers.GetAccept()),
+		SessionSourceToString(Lookup.Source),
+		LastEventId.IsSet() ? *Headers.GetLastEventId() : TEXT("<none>"));
+
+	FlushEventStream(Session, /*bForce=*/false);
+	return true;
+}
+
+bool FUEMCPServerMcpServer::HandleDeleteRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	const FUEMCPServerRequestHeaders Headers(Request.Headers);
+
+	FGuid SessionId;
+	if (!UEMCPServerHttpUtils::TryParseSessionId(Headers.GetSessionId(), SessionId))
+	{
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::BadRequest, TEXT("missing_session"), TEXT("Mcp-Session-Id header is required.")));
+		return true;
+	}
+
+	const TSharedPtr<FUEMCPServerMcpSession> Session = SessionTable.RemoveSession(SessionId);
 	if (!Session.IsValid())
 	{
-		Session = CreateSession(Endpoint, SessionId);
-		bCreatedSession = true;
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::NotFound, TEXT("unknown_session"), TEXT("MCP session not found.")));
+		return true;
 	}
 
-	static const FString KeepAlivePayload(TEXT(": keep-alive\n\n"));
+	CloseSession(Session, *AdmissionControl);
+	UE_LOG(LogUEMCPServer, Display, TEXT("MCP session %s terminated by client."), *SessionId.ToString(EGuidFormats::DigitsWithHyphens));
 
-	TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Create(KeepAlivePayload, UEMCPServer::ContentTypeEventStreamResponse);
-	Response->Headers.Add(UEMCPServer::CacheControlHeader, { UEMCPServer::NoStoreValue });
-	Response->Headers.Add(UEMCPServer::SessionIdHeader, { SessionId.ToString(EGuidFormats::DigitsWithHyphens) });
-	Response->Headers.Add(UEMCPServer::ProtocolVersionHeader, { UEMCPServer::ProtocolVersionValue });
-	UE_LOG(LogUEMCPServer, Verbose, TEXT("%s -> GET SSE %s"),
-		*UEMCPServerHttpUtils::MakeLogContext(TEXT("GET"), Endpoint, SessionId, FString(), AcceptHeaderValue),
-		bCreatedSession ? TEXT("created new session") : TEXT("keep-alive"));
+	TUniquePtr<FHttpServerResponse> Response = FHttpServerResponse::Ok();
+	AddMcpHeaders(*Response, SessionId);
 	OnComplete(MoveTemp(Response));
 	return true;
 }
 
-TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerMcpServer::FindSessionById(const FGuid& ClientId)
+bool FUEMCPServerMcpServer::TickSessions(float DeltaTime)
 {
-	FScopeLock Guard(&SessionMutex);
-	if (const TSharedPtr<FUEMCPServerMcpSession>* SessionPtr = Sessions.Find(ClientId))
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Evicted : SessionTable.EvictIdleSessions(FPlatformTime::Seconds()))
+	{
+		CloseSession(Evicted, *AdmissionControl);
+	}
+
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Session : SessionTable.GetSessions())
 	{
-		return *SessionPtr;
+		FlushEventStream(Session, /*bForce=*/false);
 	}
-	return nullptr;
+	return true;
 }
 
-TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerMcpServer::CreateSession(const FString& Endpoint, FGuid& OutSessionId)
+void FUEMCPServerMcpServer::HandleCompileFinished(ELiveCodingCompileResult Result)
 {
-	FScopeLock Guard(&SessionMutex);
-	OutSessionId = FGuid::NewGuid();
-
-	TSharedPtr<FUEMCPServerMcpSession> Session = MakeShared<FUEMCPServerMcpSession>(LiveCodingManager, OutSessionId, Endpoint);
-	Sessions.Add(OutSessionId, Session);
-	EndpointToSession.Add(Endpoint, OutSessionId);
+	const FString ResultString = UEMCPServer::CompileResultToString(Result);
+	const bool bFailed = Result == ELiveCodingCompileResult::Failure || Result == ELiveCodingCompileResult::CompileStillActive;
 
-	UE_LOG(LogUEMCPServer, Display, TEXT("MCP session created for client %s (%s)."), *OutSessionId.ToString(EGuidFormats::DigitsWithHyphens), *Endpoint);
-	return Session;
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Session : SessionTable.GetSessions())
+	{
+		Session->QueueLogMessage(bFailed ? "error" : "info", [&ResultString](FUEMCPServerJsonWriter& Writer)
+		{
+			Writer.WriteStringField("logger", "liveCoding");
+			Writer.BeginObject("data");
+			Writer.WriteStringField("event", "compileFinished");
+			Writer.WriteStringField("compileResult", ResultString);
+			Writer.WriteStringField("message", FString::Printf(TEXT("Live Coding compile finished: %s."), *ResultString));
+			Writer.EndObject();
+		});
+		FlushEventStream(Session, /*bForce=*/false);
+	}
 }
 
-TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerMcpServer::FindSessionForEndpoint(const FString& Endpoint, FGuid& OutSessionId)
+void FUEMCPServerMcpServer::HandleCompileLog(TConstArrayView<FUEMCPServerLogEntry> Entries)
 {
-	FScopeLock Guard(&SessionMutex);
-	if (const FGuid* SessionIdPtr = EndpointToSession.Find(Endpoint))
+	// The batch is reported at the level of its most severe line so clients can spot errors without reading it.
+	const ANSICHAR* Level = "info";
+	for (const FUEMCPServerLogEntry& Entry : Entries)
 	{
-		if (TSharedPtr<FUEMCPServerMcpSession>* SessionPtr = Sessions.Find(*SessionIdPtr))
+		if (Entry.Verbosity <= ELogVerbosity::Error)
+		{
+			Level = "error";
+			break;
+		}
+		if (Entry.Verbosity == ELogVerbosity::Warning)
 		{
-			OutSessionId = *SessionIdPtr;
-			return *SessionPtr;
+			Level = "warning";
 		}
 	}
-	return nullptr;
+
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Session : SessionTable.GetSessions())
+	{
+		Session->QueueLogMessage(Level, [Entries](FUEMCPServerJsonWriter& Writer)
+		{
+			Writer.WriteStringField("logger", "liveCoding");
+			Writer.BeginObject("data");
+			Writer.WriteStringField("event", "compileLog");
+			Writer.BeginArray("lines");
+			for (const FUEMCPServerLogEntry& Entry : Entries)
+			{
+				Writer.BeginObject();
+				Writer.WriteIntField("sequence", Entry.Sequence);
+				Writer.WriteIso8601Field("timeUtc", Entry.Timestamp);
+				Writer.WriteStringField("category", FNameBuilder(Entry.Category).ToView());
+				Writer.WriteStringField("verbosity", FStringView(::ToString(Entry.Verbosity)));
+				Writer.WriteStringField("message", Entry.Message);
+				Writer.EndObject();
+			}
+			Writer.EndArray();
+			Writer.EndObject();
+		});
+		FlushEventStream(Session, /*bForce=*/false);
+	}
 }
 
-TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerMcpServer::FindDefaultSession(FGuid& OutSessionId)
+void FUEMCPServerMcpServer::HandleToolsListChanged()
 {
-	FScopeLock Guard(&SessionMutex);
-	if (Sessions.Num() == 1)
+	const bool bCanFlush = IsInGameThread();
+	for (const TSharedPtr<FUEMCPServerMcpSession>& Session : SessionTable.GetSessions())
 	{
-		for (const TPair<FGuid, TSharedPtr<FUEMCPServerMcpSession>>& Pair : Sessions)
+		Session->QueueNotification(UEMCPServer::ToolsListChangedNotification, [](FUEMCPServerJsonWriter&) {});
+		if (bCanFlush)
 		{
-			OutSessionId = Pair.Key;
-			return Pair.Value;
+			FlushEventStream(Session, /*bForce=*/false);
 		}
 	}
-	return nullptr;
 }
 
-void FUEMCPServerMcpServer::AssociateEndpointWithSession(const FString& Endpoint, const FGuid& SessionId)
+void FUEMCPServerMcpServer::RegisterServerTools()
+{
+	TSharedRef<FJsonObject> InputSchema = MakeShared<FJsonObject>();
+	InputSchema->SetStringField(TEXT("type"), TEXT("object"));
+	InputSchema->SetObjectField(TEXT("properties"), MakeShared<FJsonObject>());
+	InputSchema->SetBoolField(TEXT("additionalProperties"), false);
+
+	FUEMCPServerToolDefinition MetricsTool;
+	MetricsTool.Name = UEMCPServer::MetricsToolName;
+	MetricsTool.Title = TEXT("Get MCP Server Metrics");
+	MetricsTool.Description = TEXT("Return MCP server counters: sessions created, evicted or terminated, requests admitted or rate limited, and response compression ratio and CPU time.");
+	MetricsTool.InputSchema = InputSchema;
+	MetricsTool.bReadOnlyHint = true;
+	MetricsTool.Handler = [this](const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		OnComplete(FUEMCPServerToolResult::Make([this](FUEMCPServerJsonWriter& Writer)
+		{
+			return WriteMetrics(Writer);
+		}));
+	};
+	FUEMCPServerToolRegistry::Get().RegisterTool(MoveTemp(MetricsTool));
+
+	TSharedRef<FJsonObject> TraceProperties = MakeShared<FJsonObject>();
+	{
+		TSharedRef<FJsonObject> LimitProperty = MakeShared<FJsonObject>();
+		LimitProperty->SetStringField(TEXT("type"), TEXT("integer"));
+		LimitProperty->SetNumberField(TEXT("minimum"), 1);
+		LimitProperty->SetNumberField(TEXT("maximum"), FUEMCPServerRequestTraceBuffer::Capacity);
+		LimitProperty->SetStringField(TEXT("description"), FString::Printf(TEXT("Maximum number of requests to return, newest first. Defaults to %d."), UEMCPServer::DefaultTraceLimit));
+		TraceProperties->SetObjectField(TEXT("limit"), LimitProperty);
+
+		TSharedRef<FJsonObject> MinDurationProperty = MakeShared<FJsonObject>();
+		MinDurationProperty->SetStringField(TEXT("type"), TEXT("number"));
+		MinDurationProperty->SetNumberField(TEXT("minimum"), 0);
+		MinDurationProperty->SetStringField(TEXT("description"), TEXT("Only return requests that took at least this many milliseconds from receipt to completion."));
+		TraceProperties->SetObjectField(TEXT("minDurationMs"), MinDurationProperty);
+	}
+
+	TSharedRef<FJsonObject> TraceInputSchema = MakeShared<FJsonObject>();
+	TraceInputSchema->SetStringField(TEXT("type"), TEXT("object"));
+	TraceInputSchema->SetObjectField(TEXT("properties"), TraceProperties);
+	TraceInputSchema->SetBoolField(TEXT("additionalProperties"), false);
+
+	FUEMCPServerToolDefinition TraceTool;
+	TraceTool.Name = UEMCPServer::TraceToolName;
+	TraceTool.Title = TEXT("Get MCP Request Trace");
+	TraceTool.Description = TEXT("Return recently completed MCP POST requests with status, sizes and per-phase timings (parsed, dispatched, serialized, completed).");
+	TraceTool.InputSchema = TraceInputSchema;
+	TraceTool.bReadOnlyHint = true;
+	TraceTool.Handler = [TraceBufferRef = TraceBuffer](const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+	{
+		int32 Limit = UEMCPServer::DefaultTraceLimit;
+		Call.Arguments->TryGetNumberField(TEXT("limit"), Limit);
+		double MinDurationMs = 0.0;
+		Call.Arguments->TryGetNumberField(TEXT("minDurationMs"), MinDurationMs);
+
+		const TArray<FUEMCPServerRequestTrace> Records = TraceBufferRef->Snapshot(FMath::Max(Limit, 1), MinDurationMs);
+		OnComplete(FUEMCPServerToolResult::Make([&Records](FUEMCPServerJsonWriter& Writer)
+		{
+			return FUEMCPServerRequestTraceBuffer::WriteRecords(Writer, Records);
+		}));
+	};
+	FUEMCPServerToolRegistry::Get().RegisterTool(MoveTemp(TraceTool));
+}
+
+void FUEMCPServerMcpServer::UnregisterServerTools()
+{
+	FUEMCPServerToolRegistry::Get().UnregisterTool(UEMCPServer::MetricsToolName);
+	FUEMCPServerToolRegistry::Get().UnregisterTool(UEMCPServer::TraceToolName);
+}
+
+FString FUEMCPServerMcpServer::WriteMetrics(FUEMCPServerJsonWriter& Writer) const
 {
-	FScopeLock Guard(&SessionMutex);
-	EndpointToSession.Add(Endpoint, SessionId);
+	const FUEMCPServerSessionMetrics SessionMetrics = SessionTable.GetMetrics();
+
+	Writer.BeginObject("sessions");
+	Writer.WriteIntField("live", SessionMetrics.LiveSessions);
+	Writer.WriteIntField("max", Settings.MaxSessions);
+	Writer.WriteIntField("created", static_cast<int64>(SessionMetrics.CreatedSessions));
+	Writer.WriteIntField("idleEvictions", static_cast<int64>(SessionMetrics.IdleEvictions));
+	Writer.WriteIntField("capacityEvictions", static_cast<int64>(SessionMetrics.CapacityEvictions));
+	Writer.WriteIntField("rejectedAtCapacity", static_cast<int64>(SessionMetrics.RejectedAtCapacity));
+	Writer.WriteIntField("terminatedByClient", static_cast<int64>(SessionMetrics.ClientTerminations));
+	Writer.WriteDoubleField("idleTimeoutSeconds", Settings.SessionIdleTimeoutSeconds);
+	Writer.EndObject();
+
+	const FUEMCPServerAdmissionMetrics AdmissionMetrics = AdmissionControl->GetMetrics();
+	Writer.BeginObject("admission");
+	Writer.WriteIntField("inFlight", AdmissionMetrics.InFlight);
+	Writer.WriteIntField("maxInFlight", Settings.MaxInFlightRequests);
+	Writer.WriteIntField("admitted", static_cast<int64>(AdmissionMetrics.Admitted));
+	Writer.WriteIntField("rejectedInFlight", static_cast<int64>(AdmissionMetrics.RejectedInFlight));
+	Writer.WriteIntField("rejectedSessionRate", static_cast<int64>(AdmissionMetrics.RejectedSessionRate));
+	Writer.WriteIntField("rejectedGlobalRate", static_cast<int64>(AdmissionMetrics.RejectedGlobalRate));
+	Writer.EndObject();
+
+	const FUEMCPServerCompressionMetrics CompressionMetrics = Compression->GetMetrics();
+	Writer.BeginObject("compression");
+	Writer.WriteIntField("thresholdBytes", Compression->GetThresholdBytes());
+	Writer.WriteIntField("compressed", static_cast<int64>(CompressionMetrics.Compressed));
+	Writer.WriteIntField("skippedBelowThreshold", static_cast<int64>(CompressionMetrics.SkippedBelowThreshold));
+	Writer.WriteIntField("skippedNotSmaller", static_cast<int64>(CompressionMetrics.SkippedNotSmaller));
+	Writer.WriteIntField("uncompressedBytes", static_cast<int64>(CompressionMetrics.UncompressedBytes));
+	Writer.WriteIntField("compressedBytes", static_cast<int64>(CompressionMetrics.CompressedBytes));
+	Writer.WriteDoubleField("ratio", CompressionMetrics.UncompressedBytes > 0
+		? static_cast<double>(CompressionMetrics.CompressedBytes) / static_cast<double>(CompressionMetrics.UncompressedBytes)
+		: 1.0);
+	Writer.WriteDoubleField("cpuMilliseconds", CompressionMetrics.CpuMilliseconds);
+	Writer.EndObject();
+
+	return FString::Printf(TEXT("%d live MCP session(s)."), SessionMetrics.LiveSessions);
 }
 
 bool FUEMCPServerMcpServer::ValidateProtocolVersion(const FString& ProtocolVersionHeader) const
@@ -474,16 +958,16 @@ void FUEMCPServerMcpServer::SetSessionOverrideConfig() const
 		return;
 	}
 
-	const FString BindValue = BindAddress.IsEmpty() ? TEXT("127.0.0.1") : BindAddress;
+	const FString BindValue = Settings.BindAddress.IsEmpty() ? TEXT("127.0.0.1") : Settings.BindAddress;
 
 	TArray<FString> Overrides;
 	GConfig->GetArray(UEMCPServer::HttpListenersSection, UEMCPServer::ListenerOverridesKey, Overrides, GEngineIni);
 
-	const FString DesiredEntry = FString::Printf(TEXT("(Port=%u,BindAddress=%s)"), Port, *BindValue);
+	const FString DesiredEntry = FString::Printf(TEXT("(Port=%u,BindAddress=%s)"), Settings.Port, *BindValue);
 	bool bUpdated = false;
 	for (FString& Existing : Overrides)
 	{
-		if (Existing.Contains(FString::Printf(TEXT("Port=%u"), Port)))
+		if (Existing.Contains(FString::Printf(TEXT("Port=%u"), Settings.Port)))
 		{
 			Existing = DesiredEntry;
 			bUpdated = true;
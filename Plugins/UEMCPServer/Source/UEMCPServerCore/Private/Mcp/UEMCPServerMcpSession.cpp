@@ -1,16 +1,14 @@
 #include "Mcp/UEMCPServerMcpSession.h"
+#include "Mcp/UEMCPServerJsonWriter.h"
+#include "Mcp/UEMCPServerMcpMessage.h"
 #include "Mcp/UEMCPServerMcpSchema.h"
-#include "IUEMCPServerLiveCodingProvider.h"
-#include "UEMCPServerLiveCodingTypes.h"
+#include "Mcp/UEMCPServerToolRegistry.h"
 #include "UEMCPServerLog.h"
 
 #include "Dom/JsonObject.h"
 #include "Dom/JsonValue.h"
-#include "Containers/StringConv.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/ScopeLock.h"
-#include "Serialization/JsonSerializer.h"
-#include "Serialization/JsonWriter.h"
-#include "ILiveCodingModule.h"
 
 namespace UEMCPServer::Mcp
 {
@@ -18,88 +16,349 @@ namespace UEMCPServer::Mcp
 	static const TCHAR* ToolsListMethod = TEXT("tools/list");
 	static const TCHAR* ToolsCallMethod = TEXT("tools/call");
 	static const TCHAR* PingMethod = TEXT("ping");
+	static const TCHAR* LoggingSetLevelMethod = TEXT("logging/setLevel");
 	static const TCHAR* InitializedNotification = TEXT("notifications/initialized");
+	static const TCHAR* LoggingMessageNotification = TEXT("notifications/message");
 
-	static const TCHAR* CompileToolName = TEXT("liveCoding_compile");
-	static const TCHAR* StatusToolName = TEXT("liveCoding_status");
+	/** The MCP log levels, least severe first. */
+	static const ANSICHAR* const LogLevels[] = { "debug", "info", "notice", "warning", "error", "critical", "alert", "emergency" };
 
 	static const TCHAR* ProtocolVersion = TEXT("2025-06-18");
+
+	static constexpr int32 ReplayCapacity = 256;
 }
 
 namespace
 {
-	constexpr int32 JsonRpcParseError = -32700;
 	constexpr int32 JsonRpcInvalidRequest = -32600;
 	constexpr int32 JsonRpcMethodNotFound = -32601;
 	constexpr int32 JsonRpcInvalidParams = -32602;
 	constexpr int32 JsonRpcInternalError = -32603;
 	constexpr int32 JsonRpcServerError = -32000;
+
+	/** Index of Level in LogLevels, or INDEX_NONE if it is not an MCP log level. */
+	int32 FindLogLevel(FAnsiStringView Level)
+	{
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(UEMCPServer::Mcp::LogLevels); ++Index)
+		{
+			if (Level.Equals(UEMCPServer::Mcp::LogLevels[Index]))
+			{
+				return Index;
+			}
+		}
+		return INDEX_NONE;
+	}
+
+	void WriteIdField(const TSharedPtr<FJsonValue>& IdValue, FUEMCPServerJsonWriter& Writer)
+	{
+		Writer.WriteKey("id");
+		Writer.WriteJsonValue(IdValue);
+	}
+
+	void WriteResponse(FUEMCPServerMcpReplies& Replies, const TSharedPtr<FJsonValue>& IdValue, TFunctionRef<void(FUEMCPServerJsonWriter&)> WriteResult)
+	{
+		const int32 StartOffset = Replies.Buffer.Num();
+		FUEMCPServerJsonWriter Writer(Replies.Buffer);
+		Writer.BeginObject();
+		Writer.WriteStringField("jsonrpc", "2.0");
+		WriteIdField(IdValue, Writer);
+		Writer.BeginObject("result");
+		WriteResult(Writer);
+		Writer.EndObject();
+		Writer.EndObject();
+		Replies.CommitReply(StartOffset);
+	}
+
+	void WriteError(FUEMCPServerMcpReplies& Replies, const TSharedPtr<FJsonValue>& IdValue, int32 Code, const FString& ErrorMessage, const TSharedPtr<FJsonObject>& Data = nullptr)
+	{
+		const int32 StartOffset = Replies.Buffer.Num();
+		FUEMCPServerJsonWriter Writer(Replies.Buffer);
+		Writer.BeginObject();
+		Writer.WriteStringField("jsonrpc", "2.0");
+		WriteIdField(IdValue, Writer);
+		Writer.BeginObject("error");
+		Writer.WriteIntField("code", Code);
+		Writer.WriteStringField("message", ErrorMessage);
+		if (Data.IsValid())
+		{
+			Writer.WriteKey("data");
+			Writer.WriteJsonObject(Data);
+		}
+		Writer.EndObject();
+		Writer.EndObject();
+		Replies.CommitReply(StartOffset);
+	}
+
+	void WriteToolResult(FUEMCPServerMcpReplies& Replies, const TSharedPtr<FJsonValue>& IdValue, const FUEMCPServerToolResult& Result)
+	{
+		WriteResponse(Replies, IdValue, [&Result](FUEMCPServerJsonWriter& Writer)
+		{
+			if (Result.StructuredContent.Num() > 0)
+			{
+				Writer.WriteKey("structuredContent");
+				Writer.WriteRaw(Result.StructuredContent);
+			}
+
+			Writer.BeginArray("content");
+			Writer.BeginObject();
+			Writer.WriteStringField("type", "text");
+			Writer.WriteStringField("text", Result.Message.IsEmpty() ? FStringView(TEXT(" ")) : FStringView(Result.Message));
+			Writer.EndObject();
+			Writer.EndArray();
+
+			if (Result.bIsError)
+			{
+				Writer.WriteBoolField("isError", true);
+			}
+		});
+	}
 }
 
-FUEMCPServerMcpSession::FUEMCPServerMcpSession(IUEMCPServerLiveCodingProvider& InLiveCodingManager, const FGuid& InClientId, FString InEndpoint)
-	: LiveCodingManager(InLiveCodingManager)
-	, ClientId(InClientId)
+/**
+ * One payload in flight. Its messages are dispatched in order; a deferred tool call holds the payload and resumes
+ * the dispatch when it writes its reply, and the last message hands the replies to OnHandled.
+ */
+struct FUEMCPServerMcpSession::FPendingPayload
+{
+	FCriticalSection Mutex;
+	FUEMCPServerMcpReplies Replies;
+	FUEMCPServerOnPayloadHandled OnHandled;
+
+	TArray<FUEMCPServerMcpMessage> Messages;
+	int32 NextMessage = 0;
+
+	void SendResponse(const TSharedPtr<FJsonValue>& IdValue, TFunctionRef<void(FUEMCPServerJsonWriter&)> WriteResult)
+	{
+		FScopeLock Guard(&Mutex);
+		WriteResponse(Replies, IdValue, WriteResult);
+	}
+
+	void SendError(const TSharedPtr<FJsonValue>& IdValue, int32 Code, const FString& ErrorMessage)
+	{
+		FScopeLock Guard(&Mutex);
+		WriteError(Replies, IdValue, Code, ErrorMessage);
+	}
+
+	void SendToolResult(const TSharedPtr<FJsonValue>& IdValue, const FUEMCPServerToolResult& Result)
+	{
+		FScopeLock Guard(&Mutex);
+		WriteToolResult(Replies, IdValue, Result);
+	}
+
+	void Finish()
+	{
+		FUEMCPServerMcpReplies Completed;
+		{
+			FScopeLock Guard(&Mutex);
+			Completed = MoveTemp(Replies);
+		}
+		OnHandled(MoveTemp(Completed));
+	}
+};
+
+FUEMCPServerMcpSession::FUEMCPServerMcpSession(const FGuid& InClientId, FString InEndpoint)
+	: ClientId(InClientId)
 	, Endpoint(MoveTemp(InEndpoint))
 	, bInitialized(false)
+	, LastReplyBytes(0)
+	, LastActivitySeconds(FPlatformTime::Seconds())
+	, MinLogLevel(0)
+	, RequestQueue(MakeShared<FUEMCPServerSerialQueue, ESPMode::ThreadSafe>())
+	, ParkedStreamSince(0.0)
+	, bEventStreamOpened(false)
+	, NextEventId(1)
+	, DeliveredEventId(0)
 {
 }
 
-bool FUEMCPServerMcpSession::HandleMessage(const FString& Message, TArray<FString>& OutgoingMessages)
+void FUEMCPServerMcpSession::HandlePayload(FUEMCPServerMcpPayload&& Payload, FUEMCPServerOnPayloadHandled&& OnHandled)
 {
-	FScopeLock Guard(&SessionMutex);
-	PendingMessages.Reset();
-	ProcessMessage(Message);
-	OutgoingMessages = PendingMessages;
-	PendingMessages.Reset();
-	return true;
+	TSharedRef<FPendingPayload> Pending = MakeShared<FPendingPayload>();
+	Pending->Messages = MoveTemp(Payload.Messages);
+	Pending->Replies.Buffer.Reserve(LastReplyBytes);
+	Pending->OnHandled = [WeakThis = AsWeak(), OnHandled = MoveTemp(OnHandled)](FUEMCPServerMcpReplies&& Replies)
+	{
+		if (TSharedPtr<FUEMCPServerMcpSession> This = WeakThis.Pin())
+		{
+			This->LastReplyBytes = Replies.Buffer.Num();
+		}
+		OnHandled(MoveTemp(Replies));
+	};
+
+	DispatchPending(Pending);
+}
+
+void FUEMCPServerMcpSession::DispatchPending(const TSharedRef<FPendingPayload>& Pending)
+{
+	while (Pending->NextMessage < Pending->Messages.Num())
+	{
+		const FUEMCPServerMcpMessage& Message = Pending->Messages[Pending->NextMessage++];
+		if (!ProcessMessage(Pending, Message))
+		{
+			return;
+		}
+	}
+
+	Pending->Finish();
 }
 
 void FUEMCPServerMcpSession::HandleClosed()
 {
 	bInitialized = false;
-	PendingMessages.Reset();
+
+	FScopeLock StreamGuard(&StreamMutex);
+	ReplayRing.Empty();
+	DeliveredEventId = NextEventId - 1;
+	bEventStreamOpened = false;
 }
 
-void FUEMCPServerMcpSession::ProcessMessage(const FString& Message)
+void FUEMCPServerMcpSession::QueueNotification(const FString& Method, TFunctionRef<void(FUEMCPServerJsonWriter&)> WriteParams)
 {
-	TSharedPtr<FJsonObject> Object;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
-	if (!FJsonSerializer::Deserialize(Reader, Object) || !Object.IsValid())
 	{
-		const FString ClientIdString = ClientId.ToString();
-		UE_LOG(LogUEMCPServer, Warning, TEXT("Received invalid JSON from MCP client %s"), *ClientIdString);
-		SendParseError();
+		FScopeLock StreamGuard(&StreamMutex);
+		if (!bEventStreamOpened)
+		{
+			// Nobody is listening on GET; notifications would only pile up.
+			return;
+		}
+	}
+
+	TArray<uint8> Payload;
+	FUEMCPServerJsonWriter Writer(Payload);
+	Writer.BeginObject();
+	Writer.WriteStringField("jsonrpc", "2.0");
+	Writer.WriteStringField("method", Method);
+	Writer.BeginObject("params");
+	WriteParams(Writer);
+	Writer.EndObject();
+	Writer.EndObject();
+
+	FScopeLock StreamGuard(&StreamMutex);
+	if (ReplayRing.IsEmpty())
+	{
+		ReplayRing.SetNum(UEMCPServer::Mcp::ReplayCapacity);
+	}
+
+	const int64 EventId = NextEventId++;
+	FUEMCPServerSseEvent& Slot = ReplayRing[EventId % UEMCPServer::Mcp::ReplayCapacity];
+	if (Slot.Payload.IsValid() && Slot.Id > DeliveredEventId)
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("MCP client %s event queue is full; dropping event %lld."), *ClientId.ToString(), Slot.Id);
+	}
+	Slot.Id = EventId;
+	Slot.Payload = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(MoveTemp(Payload));
+}
+
+void FUEMCPServerMcpSession::QueueLogMessage(FAnsiStringView Level, TFunctionRef<void(FUEMCPServerJsonWriter&)> WriteFields)
+{
+	if (FindLogLevel(Level) < MinLogLevel.Load())
+	{
 		return;
 	}
 
-	TSharedPtr<FJsonValue> IdValue = Object->TryGetField(TEXT("id"));
+	QueueNotification(UEMCPServer::Mcp::LoggingMessageNotification, [Level, &WriteFields](FUEMCPServerJsonWriter& Writer)
+	{
+		Writer.WriteStringField("level", Level);
+		WriteFields(Writer);
+	});
+}
+
+FHttpResultCallback FUEMCPServerMcpSession::AttachEventStream(const FHttpResultCallback& OnComplete, TOptional<int64> LastEventId)
+{
+	FScopeLock StreamGuard(&StreamMutex);
+	FHttpResultCallback Previous = MoveTemp(ParkedStream);
+	ParkedStream = OnComplete;
+	ParkedStreamSince = FPlatformTime::Seconds();
+	bEventStreamOpened = true;
+
+	if (LastEventId.IsSet())
+	{
+		// Rewind delivery to what the client confirmed; ids it never saw are replayed if still retained.
+		const int64 OldestRetained = FMath::Max<int64>(1, NextEventId - UEMCPServer::Mcp::ReplayCapacity);
+		if (LastEventId.GetValue() + 1 < OldestRetained)
+		{
+			UE_LOG(LogUEMCPServer, Warning, TEXT("MCP client %s resumed after event %lld; events before %lld are no longer retained."),
+				*ClientId.ToString(), LastEventId.GetValue(), OldestRetained);
+		}
+		DeliveredEventId = FMath::Clamp<int64>(LastEventId.GetValue(), 0, NextEventId - 1);
+	}
+	return Previous;
+}
+
+bool FUEMCPServerMcpSession::HasEventStream() const
+{
+	FScopeLock StreamGuard(&StreamMutex);
+	return ParkedStream.IsSet();
+}
+
+bool FUEMCPServerMcpSession::TryDetachEventStream(bool bForce, double HeartbeatSeconds, FHttpResultCallback& OutCallback, TArray<FUEMCPServerSseEvent>& OutEvents)
+{
+	FScopeLock StreamGuard(&StreamMutex);
+	if (!ParkedStream.IsSet())
+	{
+		return false;
+	}
+
+	const bool bHeartbeatDue = FPlatformTime::Seconds() - ParkedStreamSince >= HeartbeatSeconds;
+	const bool bHasPendingEvents = DeliveredEventId < NextEventId - 1;
+	if (!bForce && !bHeartbeatDue && !bHasPendingEvents)
+	{
+		return false;
+	}
+
+	OutCallback = MoveTemp(ParkedStream);
+	ParkedStream = nullptr;
+
+	OutEvents.Reset();
+	if (ReplayRing.IsEmpty())
+	{
+		DeliveredEventId = NextEventId - 1;
+		return true;
+	}
 
-	FString JsonRpcVersion;
-	if (!Object->TryGetStringField(TEXT("jsonrpc"), JsonRpcVersion) || JsonRpcVersion != TEXT("2.0"))
+	const int64 FirstEventId = FMath::Max<int64>(DeliveredEventId + 1, NextEventId - UEMCPServer::Mcp::ReplayCapacity);
+	for (int64 EventId = FMath::Max<int64>(FirstEventId, 1); EventId < NextEventId; ++EventId)
+	{
+		const FUEMCPServerSseEvent& Slot = ReplayRing[EventId % UEMCPServer::Mcp::ReplayCapacity];
+		if (Slot.Id == EventId && Slot.Payload.IsValid())
+		{
+			OutEvents.Add(Slot);
+		}
+	}
+	DeliveredEventId = NextEventId - 1;
+	return true;
+}
+
+bool FUEMCPServerMcpSession::ProcessMessage(const TSharedRef<FPendingPayload>& Pending, const FUEMCPServerMcpMessage& Message)
+{
+	const TSharedPtr<FJsonValue>& IdValue = Message.Id;
+	if (!Message.IsValid())
+	{
+		Pending->SendError(IdValue, JsonRpcInvalidRequest, TEXT("JSON-RPC messages must be objects."));
+		return true;
+	}
+
+	if (!Message.bIsJsonRpc20)
 	{
 		const FString ClientIdString = ClientId.ToString();
 		UE_LOG(LogUEMCPServer, Warning, TEXT("Received non JSON-RPC 2.0 message from MCP client %s"), *ClientIdString);
-		SendError(IdValue, JsonRpcInvalidRequest, TEXT("Only JSON-RPC 2.0 is supported."));
-		return;
+		Pending->SendError(IdValue, JsonRpcInvalidRequest, TEXT("Only JSON-RPC 2.0 is supported."));
+		return true;
 	}
 
-	FString Method;
-	if (!Object->TryGetStringField(TEXT("method"), Method))
+	if (!Message.IsRequest())
 	{
 		// Response from client; nothing to do.
-		return;
+		return true;
 	}
 
-	TSharedPtr<FJsonObject> ParamsObject;
-	if (Object->HasTypedField<EJson::Object>(TEXT("params")))
-	{
-		ParamsObject = Object->GetObjectField(TEXT("params"));
-	}
+	const FString& Method = Message.Method;
+	const TSharedPtr<FJsonObject>& ParamsObject = Message.Params;
 
 	if (Method == UEMCPServer::Mcp::InitializeMethod)
 	{
-		RespondInitialize(IdValue, ParamsObject);
-		return;
+		RespondInitialize(*Pending, IdValue, ParamsObject);
+		return true;
 	}
 
 	if (!IdValue.IsValid())
@@ -110,34 +369,40 @@ void FUEMCPServerMcpSession::ProcessMessage(const FString& Message)
 			const FString ClientIdString = ClientId.ToString();
 			UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s acknowledged initialization."), *ClientIdString);
 		}
-		return;
+		return true;
 	}
 
 	if (!bInitialized)
 	{
-		SendError(IdValue, JsonRpcServerError, TEXT("Client must complete initialize before issuing requests."));
-		return;
+		Pending->SendError(IdValue, JsonRpcServerError, TEXT("Client must complete initialize before issuing requests."));
+		return true;
 	}
 
 	if (Method == UEMCPServer::Mcp::ToolsListMethod)
 	{
-		RespondToolsList(IdValue);
+		RespondToolsList(*Pending, IdValue);
 	}
 	else if (Method == UEMCPServer::Mcp::ToolsCallMethod)
 	{
-		RespondToolsCall(IdValue, ParamsObject);
+		return RespondToolsCall(Pending, IdValue, ParamsObject);
 	}
 	else if (Method == UEMCPServer::Mcp::PingMethod)
 	{
-		RespondPing(IdValue);
+		RespondPing(*Pending, IdValue);
+	}
+	else if (Method == UEMCPServer::Mcp::LoggingSetLevelMethod)
+	{
+		RespondSetLevel(*Pending, IdValue, ParamsObject);
 	}
 	else
 	{
-		SendError(IdValue, JsonRpcMethodNotFound, FString::Printf(TEXT("Method '%s' is not implemented."), *Method));
+		Pending->SendError(IdValue, JsonRpcMethodNotFound, FString::Printf(TEXT("Method '%s' is not implemented."), *Method));
 	}
+	return true;
 }
 
-void FUEMCPServerMcpSession::RespondInitialize(const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params)
+
+void FUEMCPServerMcpSession::RespondInitialize(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params)
 {
 	FString RequestedProtocol = UEMCPServer::Mcp::ProtocolVersion;
 	if (Params.IsValid())
@@ -149,23 +414,25 @@ void FUEMCPServerMcpSession::RespondInitialize(const TSharedPtr<FJsonValue>& IdV
 		}
 	}
 
-	TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
-	Result->SetStringField(TEXT("protocolVersion"), RequestedProtocol);
-
-	TSharedPtr<FJsonObject> ServerInfo = MakeShared<FJsonObject>();
-	ServerInfo->SetStringField(TEXT("name"), TEXT("UE MCP Server"));
-	ServerInfo->SetStringField(TEXT("version"), TEXT("1.0.0"));
-	Result->SetObjectField(TEXT("serverInfo"), ServerInfo);
-
-	TSharedPtr<FJsonObject> Capabilities = MakeShared<FJsonObject>();
-	TSharedPtr<FJsonObject> ToolsCaps = MakeShared<FJsonObject>();
-	ToolsCaps->SetBoolField(TEXT("listChanged"), false);
-	Capabilities->SetObjectField(TEXT("tools"), ToolsCaps);
-	Result->SetObjectField(TEXT("capabilities"), Capabilities);
-
-	Result->SetStringField(TEXT("instructions"), TEXT("Use tools/list to discover the available Live Coding tools. Call liveCoding_compile to trigger a compile or liveCoding_status for the latest snapshot."));
-
-	SendResponse(IdValue, Result);
+	Pending.SendResponse(IdValue, [&RequestedProtocol](FUEMCPServerJsonWriter& Writer)
+	{
+		Writer.WriteStringField("protocolVersion", RequestedProtocol);
+
+		Writer.BeginObject("serverInfo");
+		Writer.WriteStringField("name", "UE MCP Server");
+		Writer.WriteStringField("version", "1.0.0");
+		Writer.EndObject();
+
+		Writer.BeginObject("capabilities");
+		Writer.BeginObject("tools");
+		Writer.WriteBoolField("listChanged", true);
+		Writer.EndObject();
+		Writer.BeginObject("logging");
+		Writer.EndObject();
+		Writer.EndObject();
+
+		Writer.WriteStringField("instructions", "Use tools/list to discover the available Live Coding tools. Call liveCoding_compile with waitForCompletion=true to compile and receive the final result, or liveCoding_status for the latest snapshot.");
+	});
 
 	bInitialized = true;
 
@@ -173,248 +440,80 @@ void FUEMCPServerMcpSession::RespondInitialize(const TSharedPtr<FJsonValue>& IdV
 	UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s initialized (%s)."), *ClientIdString, Endpoint.IsEmpty() ? TEXT("unknown") : *Endpoint);
 }
 
-void FUEMCPServerMcpSession::RespondToolsList(const TSharedPtr<FJsonValue>& IdValue)
+void FUEMCPServerMcpSession::RespondToolsList(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue)
 {
-	TArray<TSharedPtr<FJsonValue>> Tools;
-	UEMCPServerMcpSchema::PopulateToolsList(Tools);
-
-	TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
-	Result->SetArrayField(TEXT("tools"), Tools);
+	const TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> Tools = UEMCPServerMcpSchema::GetSerializedToolsList();
 
-	SendResponse(IdValue, Result);
+	Pending.SendResponse(IdValue, [&Tools](FUEMCPServerJsonWriter& Writer)
+	{
+		Writer.WriteKey("tools");
+		Writer.WriteRaw(*Tools);
+	});
 }
 
-void FUEMCPServerMcpSession::RespondToolsCall(const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params)
+bool FUEMCPServerMcpSession::RespondToolsCall(const TSharedRef<FPendingPayload>& Pending, const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params)
 {
 	if (!Params.IsValid())
 	{
-		SendError(IdValue, JsonRpcInvalidParams, TEXT("Missing params object for tools/call."));
-		return;
+		Pending->SendError(IdValue, JsonRpcInvalidParams, TEXT("Missing params object for tools/call."));
+		return true;
 	}
 
 	FString ToolName;
 	if (!Params->TryGetStringField(TEXT("name"), ToolName) || ToolName.IsEmpty())
 	{
-		SendError(IdValue, JsonRpcInvalidParams, TEXT("Missing tool name for tools/call."));
-		return;
+		Pending->SendError(IdValue, JsonRpcInvalidParams, TEXT("Missing tool name for tools/call."));
+		return true;
 	}
 
-	if (ToolName == UEMCPServer::Mcp::CompileToolName)
-	{
-		HandleCompileTool(IdValue);
-	}
-	else if (ToolName == UEMCPServer::Mcp::StatusToolName)
-	{
-		HandleStatusTool(IdValue);
-	}
-	else
+	const FUEMCPServerToolPtr Tool = FUEMCPServerToolRegistry::Get().FindTool(ToolName);
+	if (!Tool.IsValid())
 	{
-		SendError(IdValue, JsonRpcMethodNotFound, FString::Printf(TEXT("Unknown tool '%s'."), *ToolName));
-	}
-}
-
-void FUEMCPServerMcpSession::RespondPing(const TSharedPtr<FJsonValue>& IdValue)
-{
-	TSharedRef<FJsonObject> Result = MakeShared<FJsonObject>();
-	SendResponse(IdValue, Result);
-}
-
-void FUEMCPServerMcpSession::HandleCompileTool(const TSharedPtr<FJsonValue>& IdValue)
-{
-	FString ErrorMessage;
-	if (!LiveCodingManager.TryBeginCompile(ErrorMessage))
-	{
-		TSharedRef<FJsonObject> Structured = MakeShared<FJsonObject>();
-		Structured->SetStringField(TEXT("status"), TEXT("error"));
-		Structured->SetStringField(TEXT("message"), ErrorMessage);
-		Structured->SetBoolField(TEXT("compileInProgress"), true);
-		Structured->SetBoolField(TEXT("compileStarted"), false);
-		SendToolResult(IdValue, ErrorMessage, Structured, true);
-		return;
+		Pending->SendError(IdValue, JsonRpcMethodNotFound, FString::Printf(TEXT("Unknown tool '%s'."), *ToolName));
+		return true;
 	}
 
-	FString StatusMessage;
-	TSharedRef<FJsonObject> Structured = BuildLiveCodingStatus(StatusMessage);
-	StatusMessage = TEXT("Compile queued. Poll liveCoding.status for updates.");
-	Structured->SetStringField(TEXT("status"), TEXT("ok"));
-	Structured->SetStringField(TEXT("message"), StatusMessage);
-	Structured->SetBoolField(TEXT("compileStarted"), true);
-
-	SendToolResult(IdValue, StatusMessage, Structured, false);
+	const TSharedPtr<FJsonObject>* ArgumentsObject = nullptr;
+	FUEMCPServerToolCall Call{ ClientId, Params->TryGetObjectField(TEXT("arguments"), ArgumentsObject) && ArgumentsObject->IsValid()
+		? ArgumentsObject->ToSharedRef()
+		: MakeShared<FJsonObject>() };
 
-	FUEMCPServerMcpSession* SessionPtr = this;
-	AsyncTask(ENamedThreads::GameThread, [SessionPtr]()
+	// The tool may answer later or from another thread. The tool and this call each check in once; if the tool is
+	// second, it answered late and resumes the rest of the payload itself.
+	TSharedRef<TAtomic<int32>, ESPMode::ThreadSafe> CheckIns = MakeShared<TAtomic<int32>, ESPMode::ThreadSafe>(0);
+	FUEMCPServerToolRegistry::InvokeTool(Tool.ToSharedRef(), Call, [This = AsShared(), Pending, IdValue, CheckIns](FUEMCPServerToolResult&& Result)
 	{
-		if (SessionPtr)
+		Pending->SendToolResult(IdValue, Result);
+		if (CheckIns->IncrementExchange() == 1)
 		{
-			SessionPtr->LiveCodingManager.ExecuteCompileOnGameThread();
+			This->DispatchPending(Pending);
 		}
 	});
-
-	const FString ClientIdString = ClientId.ToString();
-	UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s queued Live Coding compile."), *ClientIdString);
-}
-
-void FUEMCPServerMcpSession::HandleStatusTool(const TSharedPtr<FJsonValue>& IdValue)
-{
-	FString StatusMessage;
-	TSharedRef<FJsonObject> Structured = BuildLiveCodingStatus(StatusMessage);
-	SendToolResult(IdValue, StatusMessage, Structured, false);
-
-	const FString ClientIdString = ClientId.ToString();
-	UE_LOG(LogUEMCPServer, Verbose, TEXT("MCP client %s requested Live Coding status."), *ClientIdString);
+	return CheckIns->IncrementExchange() != 0;
 }
 
-void FUEMCPServerMcpSession::SendToolResult(const TSharedPtr<FJsonValue>& IdValue, const FString& MessageText, const TSharedRef<FJsonObject>& Structured, bool bIsError)
+void FUEMCPServerMcpSession::RespondPing(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue)
 {
-	TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
-	ResultObject->SetArrayField(TEXT("content"), MakeTextContentArray(MessageText.IsEmpty() ? TEXT(" ") : MessageText));
-	ResultObject->SetObjectField(TEXT("structuredContent"), Structured);
-	if (bIsError)
-	{
-		ResultObject->SetBoolField(TEXT("isError"), true);
-	}
-
-	SendResponse(IdValue, ResultObject);
-}
-
-void FUEMCPServerMcpSession::SendResponse(const TSharedPtr<FJsonValue>& IdValue, const TSharedRef<FJsonObject>& ResultObject)
-{
-	TSharedRef<FJsonObject> Response = MakeShared<FJsonObject>();
-	Response->SetStringField(TEXT("jsonrpc"), TEXT("2.0"));
-	WriteIdField(IdValue, Response);
-	Response->SetObjectField(TEXT("result"), ResultObject);
-
-	SendJson(Response);
-}
-
-void FUEMCPServerMcpSession::SendError(const TSharedPtr<FJsonValue>& IdValue, int32 Code, const FString& ErrorMessage, const TSharedPtr<FJsonObject>& Data)
-{
-	TSharedRef<FJsonObject> ErrorObject = MakeShared<FJsonObject>();
-	ErrorObject->SetNumberField(TEXT("code"), Code);
-	ErrorObject->SetStringField(TEXT("message"), ErrorMessage);
-	if (Data.IsValid())
-	{
-		ErrorObject->SetObjectField(TEXT("data"), Data.ToSharedRef());
-	}
-
-	TSharedRef<FJsonObject> Response = MakeShared<FJsonObject>();
-	Response->SetStringField(TEXT("jsonrpc"), TEXT("2.0"));
-	WriteIdField(IdValue, Response);
-	Response->SetObjectField(TEXT("error"), ErrorObject);
-
-	SendJson(Response);
-}
-
-void FUEMCPServerMcpSession::SendParseError()
-{
-	SendError(TSharedPtr<FJsonValue>(), JsonRpcParseError, TEXT("Failed to parse JSON-RPC message."));
-}
-
-void FUEMCPServerMcpSession::SendJson(const TSharedRef<FJsonObject>& Object)
-{
-	FString Payload;
-	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Payload);
-	FJsonSerializer::Serialize(Object, Writer);
-
-	PendingMessages.Add(MoveTemp(Payload));
+	Pending.SendResponse(IdValue, [](FUEMCPServerJsonWriter&) {});
 }
 
-void FUEMCPServerMcpSession::WriteIdField(const TSharedPtr<FJsonValue>& IdValue, const TSharedRef<FJsonObject>& Target) const
+void FUEMCPServerMcpSession::RespondSetLevel(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params)
 {
-	if (!IdValue.IsValid())
+	FString Level;
+	if (!Params.IsValid() || !Params->TryGetStringField(TEXT("level"), Level))
 	{
-		Target->SetField(TEXT("id"), MakeShared<FJsonValueNull>());
+		Pending.SendError(IdValue, JsonRpcInvalidParams, TEXT("Missing level for logging/setLevel."));
 		return;
 	}
 
-	switch (IdValue->Type)
-	{
-	case EJson::String:
-		Target->SetStringField(TEXT("id"), IdValue->AsString());
-		break;
-	case EJson::Number:
-		Target->SetNumberField(TEXT("id"), IdValue->AsNumber());
-		break;
-	case EJson::Null:
-		Target->SetField(TEXT("id"), MakeShared<FJsonValueNull>());
-		break;
-	case EJson::Boolean:
-		Target->SetBoolField(TEXT("id"), IdValue->AsBool());
-		break;
-	case EJson::Array:
-	case EJson::Object:
-		Target->SetField(TEXT("id"), IdValue);
-		break;
-	}
-}
-
-TArray<TSharedPtr<FJsonValue>> FUEMCPServerMcpSession::MakeTextContentArray(const FString& MessageText) const
-{
-	TArray<TSharedPtr<FJsonValue>> Content;
-	TSharedRef<FJsonObject> ContentObject = MakeShared<FJsonObject>();
-	ContentObject->SetStringField(TEXT("type"), TEXT("text"));
-	ContentObject->SetStringField(TEXT("text"), MessageText);
-	Content.Add(MakeShared<FJsonValueObject>(ContentObject));
-	return Content;
-}
-
-TSharedRef<FJsonObject> FUEMCPServerMcpSession::BuildLiveCodingStatus(FString& OutMessage) const
-{
-	TArray<FUEMCPServerLogEntry> LogSnapshot;
-	FDateTime SnapshotTimestamp;
-	ELiveCodingCompileResult SnapshotResult = ELiveCodingCompileResult::NotStarted;
-	bool bHasSnapshotResult = false;
-	FString SnapshotError;
-	bool bInProgress = false;
-
-	LiveCodingManager.GetLastCompileSnapshot(LogSnapshot, SnapshotTimestamp, SnapshotResult, bHasSnapshotResult, SnapshotError, bInProgress);
-
-	TSharedRef<FJsonObject> Status = MakeShared<FJsonObject>();
-	const FString ResultString = UEMCPServer::CompileResultToString(SnapshotResult);
-
-	Status->SetStringField(TEXT("status"), SnapshotError.IsEmpty() ? TEXT("ok") : TEXT("error"));
-	Status->SetStringField(TEXT("compileResult"), ResultString);
-	Status->SetBoolField(TEXT("compileInProgress"), bInProgress);
-	Status->SetBoolField(TEXT("hasPreviousResult"), bHasSnapshotResult);
-	Status->SetBoolField(TEXT("compileStarted"), false);
-
-	if (SnapshotTimestamp.GetTicks() > 0)
-	{
-		Status->SetStringField(TEXT("timestampUtc"), SnapshotTimestamp.ToIso8601());
-	}
-
-	if (!SnapshotError.IsEmpty())
+	const auto LevelAnsi = StringCast<ANSICHAR>(*Level, Level.Len());
+	const int32 LevelIndex = FindLogLevel(FAnsiStringView(LevelAnsi.Get(), LevelAnsi.Length()));
+	if (LevelIndex == INDEX_NONE)
 	{
-		OutMessage = SnapshotError;
-	}
-	else if (bInProgress)
-	{
-		OutMessage = TEXT("Compile in progress.");
-	}
-	else if (!bHasSnapshotResult)
-	{
-		OutMessage = TEXT("No compile has been executed yet.");
-	}
-	else
-	{
-		OutMessage = FString::Printf(TEXT("Last compile result: %s."), *ResultString);
-	}
-
-	Status->SetStringField(TEXT("message"), OutMessage);
-
-	TArray<TSharedPtr<FJsonValue>> LogArray;
-	LogArray.Reserve(LogSnapshot.Num());
-	for (const FUEMCPServerLogEntry& Entry : LogSnapshot)
-	{
-		TSharedRef<FJsonObject> EntryObject = MakeShared<FJsonObject>();
-		EntryObject->SetStringField(TEXT("timeUtc"), Entry.Timestamp.ToIso8601());
-		EntryObject->SetStringField(TEXT("category"), Entry.Category);
-		EntryObject->SetStringField(TEXT("verbosity"), Entry.Verbosity);
-		EntryObject->SetStringField(TEXT("message"), Entry.Message);
-		LogArray.Add(MakeShared<FJsonValueObject>(EntryObject));
+		Pending.SendError(IdValue, JsonRpcInvalidParams, FString::Printf(TEXT("Unknown log level '%s'."), *Level));
+		return;
 	}
-	Status->SetArrayField(TEXT("log"), LogArray);
 
-	return Status;
+	MinLogLevel.Store(LevelIndex);
+	Pending.SendResponse(IdValue, [](FUEMCPServerJsonWriter&) {});
 }
@@ -0,0 +1,205 @@
+#include "Mcp/UEMCPServerRequestTrace.h"
+#include "Mcp/UEMCPServerJsonWriter.h"
+
+#include "HAL/PlatformMisc.h"
+#include "Misc/CString.h"
+#include "Trace/Trace.inl"
+
+UE_TRACE_CHANNEL_DEFINE(UEMCPServerChannel)
+
+UE_TRACE_EVENT_BEGIN(UEMCPServer, Request)
+	UE_TRACE_EVENT_FIELD(uint64, RequestId)
+	UE_TRACE_EVENT_FIELD(uint64, ReceivedCycle)
+	UE_TRACE_EVENT_FIELD(uint64, ParsedCycle)
+	UE_TRACE_EVENT_FIELD(uint64, DispatchedCycle)
+	UE_TRACE_EVENT_FIELD(uint64, SerializedCycle)
+	UE_TRACE_EVENT_FIELD(uint64, CompletedCycle)
+	UE_TRACE_EVENT_FIELD(int32, StatusCode)
+	UE_TRACE_EVENT_FIELD(int32, RequestBytes)
+	UE_TRACE_EVENT_FIELD(int32, ResponseBytes)
+	UE_TRACE_EVENT_FIELD(int32, MessageCount)
+	UE_TRACE_EVENT_FIELD(UE::Trace::AnsiString, Method)
+	UE_TRACE_EVENT_FIELD(UE::Trace::AnsiString, SessionId)
+UE_TRACE_EVENT_END()
+
+namespace
+{
+	uint64 PhaseCycle(const FUEMCPServerRequestTrace& Trace, EUEMCPServerRequestPhase Phase)
+	{
+		return Trace.PhaseCycles[static_cast<int32>(Phase)];
+	}
+
+	const ANSICHAR* PhaseName(EUEMCPServerRequestPhase Phase)
+	{
+		switch (Phase)
+		{
+		case EUEMCPServerRequestPhase::Received:
+			return "received";
+		case EUEMCPServerRequestPhase::Parsed:
+			return "parsed";
+		case EUEMCPServerRequestPhase::Dispatched:
+			return "dispatched";
+		case EUEMCPServerRequestPhase::Serialized:
+			return "serialized";
+		case EUEMCPServerRequestPhase::Completed:
+			return "completed";
+		default:
+			return "unknown";
+		}
+	}
+}
+
+void FUEMCPServerRequestTrace::SetMethod(const FString& InMethod)
+{
+	int32 Length = 0;
+	for (const TCHAR Char : InMethod)
+	{
+		if (Length == UE_ARRAY_COUNT(Method) - 1)
+		{
+			break;
+		}
+		// Method names are ASCII; anything else would only garble the record.
+		Method[Length++] = Char < 0x80 ? static_cast<ANSICHAR>(Char) : '?';
+	}
+	Method[Length] = '\0';
+}
+
+double FUEMCPServerRequestTrace::GetElapsedMilliseconds(EUEMCPServerRequestPhase Phase) const
+{
+	const uint64 Start = PhaseCycle(*this, EUEMCPServerRequestPhase::Received);
+	const uint64 End = PhaseCycle(*this, Phase);
+	if (Start == 0 || End < Start)
+	{
+		return -1.0;
+	}
+	return FPlatformTime::ToMilliseconds64(End - Start);
+}
+
+FString FUEMCPServerRequestTrace::Describe() const
+{
+	return FString::Printf(TEXT("POST #%llu method=%hs session=%s"),
+		RequestId,
+		Method[0] != '\0' ? Method : "<none>",
+		SessionId.IsValid() ? *SessionId.ToString(EGuidFormats::DigitsWithHyphens) : TEXT("<none>"));
+}
+
+FUEMCPServerRequestTraceBuffer::FUEMCPServerRequestTraceBuffer()
+	: NextId(0)
+	, WriteCursor(0)
+{
+	for (FSlot& Slot : Slots)
+	{
+		Slot.Sequence = 0;
+	}
+}
+
+void FUEMCPServerRequestTraceBuffer::Record(const FUEMCPServerRequestTrace& Trace)
+{
+	const uint64 WriteIndex = WriteCursor.IncrementExchange();
+	FSlot& Slot = Slots[WriteIndex % Capacity];
+
+	Slot.Sequence = WriteIndex * 2 + 1;
+	FPlatformMisc::MemoryBarrier();
+	Slot.Trace = Trace;
+	FPlatformMisc::MemoryBarrier();
+	Slot.Sequence = WriteIndex * 2 + 2;
+
+	if (UE_TRACE_CHANNELEXPR_IS_ENABLED(UEMCPServerChannel))
+	{
+		const FString SessionString = Trace.SessionId.ToString(EGuidFormats::DigitsWithHyphens);
+		UE_TRACE_LOG(UEMCPServer, Request, UEMCPServerChannel)
+			<< Request.RequestId(Trace.RequestId)
+			<< Request.ReceivedCycle(PhaseCycle(Trace, EUEMCPServerRequestPhase::Received))
+			<< Request.ParsedCycle(PhaseCycle(Trace, EUEMCPServerRequestPhase::Parsed))
+			<< Request.DispatchedCycle(PhaseCycle(Trace, EUEMCPServerRequestPhase::Dispatched))
+			<< Request.SerializedCycle(PhaseCycle(Trace, EUEMCPServerRequestPhase::Serialized))
+			<< Request.CompletedCycle(PhaseCycle(Trace, EUEMCPServerRequestPhase::Completed))
+			<< Request.StatusCode(Trace.StatusCode)
+			<< Request.RequestBytes(Trace.RequestBytes)
+			<< Request.ResponseBytes(Trace.ResponseBytes)
+			<< Request.MessageCount(Trace.MessageCount)
+			<< Request.Method(Trace.Method, FCStringAnsi::Strlen(Trace.Method))
+			<< Request.SessionId(*SessionString, SessionString.Len());
+	}
+}
+
+TArray<FUEMCPServerRequestTrace> FUEMCPServerRequestTraceBuffer::Snapshot(int32 MaxRecords, double MinDurationMs) const
+{
+	TArray<FUEMCPServerRequestTrace> Records;
+	const uint64 End = WriteCursor.Load();
+	const uint64 Oldest = End > Capacity ? End - Capacity : 0;
+	MaxRecords = FMath::Clamp(MaxRecords, 0, Capacity);
+	Records.Reserve(MaxRecords);
+
+	for (uint64 WriteIndex = End; WriteIndex > Oldest && Records.Num() < MaxRecords; --WriteIndex)
+	{
+		const FSlot& Slot = Slots[(WriteIndex - 1) % Capacity];
+		const uint64 Published = (WriteIndex - 1) * 2 + 2;
+		if (Slot.Sequence.Load() != Published)
+		{
+			// Still being written, or already overwritten by a newer request.
+			continue;
+		}
+
+		FUEMCPServerRequestTrace Copy = Slot.Trace;
+		FPlatformMisc::MemoryBarrier();
+		if (Slot.Sequence.Load() != Published)
+		{
+			continue;
+		}
+
+		if (MinDurationMs > 0.0 && Copy.GetElapsedMilliseconds(EUEMCPServerRequestPhase::Completed) < MinDurationMs)
+		{
+			continue;
+		}
+		Records.Add(Copy);
+	}
+	return Records;
+}
+
+FString FUEMCPServerRequestTraceBuffer::WriteRecords(FUEMCPServerJsonWriter& Writer, TConstArrayView<FUEMCPServerRequestTrace> Records)
+{
+	double SlowestMs = 0.0;
+	Writer.BeginArray("requests");
+	for (const FUEMCPServerRequestTrace& Trace : Records)
+	{
+		Writer.BeginObject();
+		Writer.WriteIntField("requestId", static_cast<int64>(Trace.RequestId));
+		Writer.WriteStringField("method", FAnsiStringView(Trace.Method));
+		if (Trace.SessionId.IsValid())
+		{
+			Writer.WriteStringField("sessionId", Trace.SessionId.ToString(EGuidFormats::DigitsWithHyphens));
+		}
+		Writer.WriteIntField("statusCode", Trace.StatusCode);
+		Writer.WriteIntField("messageCount", Trace.MessageCount);
+		Writer.WriteIntField("requestBytes", Trace.RequestBytes);
+		Writer.WriteIntField("responseBytes", Trace.ResponseBytes);
+		if (Trace.UncompressedResponseBytes > 0)
+		{
+			Writer.WriteIntField("uncompressedResponseBytes", Trace.UncompressedResponseBytes);
+			Writer.WriteDoubleField("compressionRatio", static_cast<double>(Trace.ResponseBytes) / Trace.UncompressedResponseBytes);
+		}
+		if (Trace.CompressCycles > 0)
+		{
+			Writer.WriteDoubleField("compressMs", FPlatformTime::ToMilliseconds64(Trace.CompressCycles));
+		}
+
+		// Phase offsets from receipt; phases the request never reached are left out.
+		Writer.BeginObject("phasesMs");
+		for (int32 Phase = static_cast<int32>(EUEMCPServerRequestPhase::Parsed); Phase < static_cast<int32>(EUEMCPServerRequestPhase::Count); ++Phase)
+		{
+			const double ElapsedMs = Trace.GetElapsedMilliseconds(static_cast<EUEMCPServerRequestPhase>(Phase));
+			if (ElapsedMs >= 0.0)
+			{
+				Writer.WriteDoubleField(PhaseName(static_cast<EUEMCPServerRequestPhase>(Phase)), ElapsedMs);
+			}
+		}
+		Writer.EndObject();
+		Writer.EndObject();
+
+		SlowestMs = FMath::Max(SlowestMs, Trace.GetElapsedMilliseconds(EUEMCPServerRequestPhase::Completed));
+	}
+	Writer.EndArray();
+
+	return FString::Printf(TEXT("%d traced request(s); slowest %.1f ms."), Records.Num(), SlowestMs);
+}
@@ -0,0 +1,120 @@
+#include "Mcp/UEMCPServerResponseCompression.h"
+#include "Mcp/UEMCPServerHttpUtils.h"
+#include "Mcp/UEMCPServerMcpSettings.h"
+
+#include "HttpServerResponse.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Compression.h"
+
+namespace UEMCPServer::Compression
+{
+	static constexpr const TCHAR* ContentEncodingHeader = TEXT("content-encoding");
+	static constexpr const TCHAR* VaryHeader = TEXT("vary");
+	static constexpr const TCHAR* AcceptEncodingValue = TEXT("Accept-Encoding");
+}
+
+FUEMCPServerResponseCompression::FUEMCPServerResponseCompression(const FUEMCPServerMcpServerSettings& Settings)
+	: ThresholdBytes(Settings.CompressionThresholdBytes)
+	, Compressed(0)
+	, SkippedBelowThreshold(0)
+	, SkippedNotSmaller(0)
+	, UncompressedBytes(0)
+	, CompressedBytes(0)
+	, CompressCycles(0)
+{
+}
+
+EUEMCPServerContentEncoding FUEMCPServerResponseCompression::NegotiateEncoding(FStringView AcceptEncoding)
+{
+	uint16 GzipQuality = 0;
+	uint16 DeflateQuality = 0;
+	uint16 WildcardQuality = 0;
+	bool bGzipListed = false;
+	bool bDeflateListed = false;
+
+	FStringView Coding;
+	uint16 Quality = 0;
+	while (UEMCPServerHttpUtils::NextListElement(AcceptEncoding, Coding, Quality))
+	{
+		if (Coding.Equals(TEXT("gzip"), ESearchCase::IgnoreCase) || Coding.Equals(TEXT("x-gzip"), ESearchCase::IgnoreCase))
+		{
+			GzipQuality = Quality;
+			bGzipListed = true;
+		}
+		else if (Coding.Equals(TEXT("deflate"), ESearchCase::IgnoreCase))
+		{
+			DeflateQuality = Quality;
+			bDeflateListed = true;
+		}
+		else if (Coding == TEXT("*"))
+		{
+			WildcardQuality = Quality;
+		}
+	}
+
+	// A coding not named explicitly takes the wildcard's quality.
+	GzipQuality = bGzipListed ? GzipQuality : WildcardQuality;
+	DeflateQuality = bDeflateListed ? DeflateQuality : WildcardQuality;
+
+	if (GzipQuality == 0 && DeflateQuality == 0)
+	{
+		return EUEMCPServerContentEncoding::Identity;
+	}
+	return GzipQuality >= DeflateQuality ? EUEMCPServerContentEncoding::Gzip : EUEMCPServerContentEncoding::Deflate;
+}
+
+uint64 FUEMCPServerResponseCompression::CompressResponse(FHttpServerResponse& Response, EUEMCPServerContentEncoding Encoding)
+{
+	if (Encoding == EUEMCPServerContentEncoding::Identity || ThresholdBytes <= 0)
+	{
+		return 0;
+	}
+
+	const int32 BodyBytes = Response.Body.Num();
+	if (BodyBytes < ThresholdBytes)
+	{
+		SkippedBelowThreshold.IncrementExchange();
+		return 0;
+	}
+
+	// HTTP "deflate" is the zlib stream format, not raw deflate.
+	const FName FormatName = Encoding == EUEMCPServerContentEncoding::Gzip ? NAME_Gzip : NAME_Zlib;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	TArray<uint8> CompressedBody;
+	int32 CompressedSize = FCompression::CompressMemoryBound(FormatName, BodyBytes);
+	CompressedBody.SetNumUninitialized(CompressedSize);
+	const bool bCompressed = FCompression::CompressMemory(FormatName, CompressedBody.GetData(), CompressedSize,
+		Response.Body.GetData(), BodyBytes, COMPRESS_BiasSpeed);
+	const uint64 SpentCycles = FPlatformTime::Cycles64() - StartCycles;
+	CompressCycles.AddExchange(SpentCycles);
+
+	if (!bCompressed || CompressedSize >= BodyBytes)
+	{
+		SkippedNotSmaller.IncrementExchange();
+		return SpentCycles;
+	}
+
+	CompressedBody.SetNum(CompressedSize, EAllowShrinking::No);
+	Response.Body = MoveTemp(CompressedBody);
+	Response.Headers.Add(UEMCPServer::Compression::ContentEncodingHeader,
+		{ Encoding == EUEMCPServerContentEncoding::Gzip ? FString(TEXT("gzip")) : FString(TEXT("deflate")) });
+	Response.Headers.Add(UEMCPServer::Compression::VaryHeader, { UEMCPServer::Compression::AcceptEncodingValue });
+
+	Compressed.IncrementExchange();
+	UncompressedBytes.AddExchange(BodyBytes);
+	CompressedBytes.AddExchange(CompressedSize);
+	return SpentCycles;
+}
+
+FUEMCPServerCompressionMetrics FUEMCPServerResponseCompression::GetMetrics() const
+{
+	FUEMCPServerCompressionMetrics Metrics;
+	Metrics.Compressed = Compressed.Load();
+	Metrics.SkippedBelowThreshold = SkippedBelowThreshold.Load();
+	Metrics.SkippedNotSmaller = SkippedNotSmaller.Load();
+	Metrics.UncompressedBytes = UncompressedBytes.Load();
+	Metrics.CompressedBytes = CompressedBytes.Load();
+	Metrics.CpuMilliseconds = FPlatformTime::ToMilliseconds64(CompressCycles.Load());
+	return Metrics;
+}
@@ -0,0 +1,69 @@
+#include "Mcp/UEMCPServerSerialQueue.h"
+
+#include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/Atomic.h"
+
+void FUEMCPServerSerialQueue::Enqueue(TUniqueFunction<void()>&& Work)
+{
+	EnqueueAsync([Work = MoveTemp(Work)](FOnWorkDone&& OnDone)
+	{
+		Work();
+		OnDone();
+	});
+}
+
+void FUEMCPServerSerialQueue::EnqueueAsync(TUniqueFunction<void(FOnWorkDone&&)>&& Work)
+{
+	{
+		FScopeLock Guard(&Mutex);
+		Pending.Add(MoveTemp(Work));
+		if (bDraining)
+		{
+			return;
+		}
+		bDraining = true;
+	}
+
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [This = AsShared()]()
+	{
+		This->Drain();
+	});
+}
+
+void FUEMCPServerSerialQueue::Drain()
+{
+	for (;;)
+	{
+		TUniqueFunction<void(FOnWorkDone&&)> Work;
+		{
+			FScopeLock Guard(&Mutex);
+			if (Pending.IsEmpty())
+			{
+				bDraining = false;
+				return;
+			}
+			Work = MoveTemp(Pending[0]);
+			Pending.RemoveAt(0, 1, EAllowShrinking::No);
+		}
+
+		// The item and this loop each check in once; whichever is second carries on draining, so an item that
+		// finishes on another thread resumes the queue from there.
+		TSharedRef<TAtomic<int32>, ESPMode::ThreadSafe> CheckIns = MakeShared<TAtomic<int32>, ESPMode::ThreadSafe>(0);
+		Work([This = AsShared(), CheckIns]()
+		{
+			if (CheckIns->IncrementExchange() == 1)
+			{
+				AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [This]()
+				{
+					This->Drain();
+				});
+			}
+		});
+
+		if (CheckIns->IncrementExchange() == 0)
+		{
+			return;
+		}
+	}
+}
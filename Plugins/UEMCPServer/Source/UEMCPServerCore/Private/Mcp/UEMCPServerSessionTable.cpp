@@ -0,0 +1,291 @@
+#include "Mcp/UEMCPServerSessionTable.h"
+#include "Mcp/UEMCPServerMcpSession.h"
+#include "UEMCPServerLog.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeRWLock.h"
+
+namespace UEMCPServer::Sessions
+{
+	static constexpr int32 TimerWheelSlots = 64;
+	static constexpr double MinWheelGranularitySeconds = 1.0;
+	static constexpr int32 MaxEndpointsPerSession = 8;
+}
+
+FUEMCPServerSessionTable::FUEMCPServerSessionTable(double InIdleTimeoutSeconds, int32 InMaxSessions)
+	: IdleTimeoutSeconds(FMath::Max(InIdleTimeoutSeconds, 1.0))
+	, MaxSessions(FMath::Max(InMaxSessions, 1))
+	, WheelGranularitySeconds(FMath::Max(IdleTimeoutSeconds / UEMCPServer::Sessions::TimerWheelSlots, UEMCPServer::Sessions::MinWheelGranularitySeconds))
+	, WheelCursor(FMath::FloorToInt64(FPlatformTime::Seconds() / WheelGranularitySeconds))
+{
+	TimerWheel.SetNum(UEMCPServer::Sessions::TimerWheelSlots);
+}
+
+FUEMCPServerSessionLookup FUEMCPServerSessionTable::ResolveSession(const FGuid* RequestedId, const FString& Endpoint, bool bAllowCreate)
+{
+	FUEMCPServerSessionLookup Lookup;
+	{
+		FReadScopeLock ReadGuard(Lock);
+		if (RequestedId)
+		{
+			if (const TSharedPtr<FUEMCPServerMcpSession>* Found = Sessions.Find(*RequestedId))
+			{
+				Lookup.Session = *Found;
+				Lookup.SessionId = *RequestedId;
+				Lookup.Source = EUEMCPServerSessionSource::Header;
+			}
+		}
+		else if (const FGuid* EndpointSessionId = EndpointToSession.Find(Endpoint))
+		{
+			if (const TSharedPtr<FUEMCPServerMcpSession>* Found = Sessions.Find(*EndpointSessionId))
+			{
+				Lookup.Session = *Found;
+				Lookup.SessionId = *EndpointSessionId;
+				Lookup.Source = EUEMCPServerSessionSource::Endpoint;
+			}
+		}
+
+		if (!Lookup.Session.IsValid() && !RequestedId && Sessions.Num() == 1)
+		{
+			for (const TPair<FGuid, TSharedPtr<FUEMCPServerMcpSession>>& Pair : Sessions)
+			{
+				Lookup.Session = Pair.Value;
+				Lookup.SessionId = Pair.Key;
+				Lookup.Source = EUEMCPServerSessionSource::Default;
+			}
+		}
+
+		if (Lookup.Session.IsValid() && IsEndpointMapped(Endpoint, Lookup.SessionId))
+		{
+			// Hot path: nothing to update.
+			Lookup.Session->Touch();
+			return Lookup;
+		}
+	}
+
+	if (RequestedId && !Lookup.Session.IsValid())
+	{
+		return Lookup;
+	}
+
+	if (!Lookup.Session.IsValid() && !bAllowCreate)
+	{
+		return Lookup;
+	}
+
+	FWriteScopeLock WriteGuard(Lock);
+	if (Lookup.Session.IsValid())
+	{
+		// The session may have been removed while the lock was released.
+		if (Sessions.Contains(Lookup.SessionId))
+		{
+			MapEndpoint(Endpoint, Lookup.SessionId);
+			Lookup.Session->Touch();
+			return Lookup;
+		}
+		if (!bAllowCreate)
+		{
+			return FUEMCPServerSessionLookup();
+		}
+	}
+
+	FUEMCPServerSessionLookup Created;
+	while (Sessions.Num() >= MaxSessions)
+	{
+		TSharedPtr<FUEMCPServerMcpSession> Evicted = EvictLeastRecentlyUsedLocked();
+		if (!Evicted.IsValid())
+		{
+			UE_LOG(LogUEMCPServer, Warning, TEXT("MCP session limit (%d) reached and every session is streaming; refusing a new session for %s."),
+				MaxSessions, *Endpoint);
+			++Metrics.RejectedAtCapacity;
+			Created.bSessionLimitReached = true;
+			return Created;
+		}
+		Created.Evicted.Add(MoveTemp(Evicted));
+	}
+
+	Created.SessionId = FGuid::NewGuid();
+	Created.Session = MakeShared<FUEMCPServerMcpSession>(Created.SessionId, Endpoint);
+	Created.Source = EUEMCPServerSessionSource::Created;
+	Sessions.Add(Created.SessionId, Created.Session);
+	MapEndpoint(Endpoint, Created.SessionId);
+	ScheduleExpiry(Created.SessionId, Created.Session->GetLastActivitySeconds() + IdleTimeoutSeconds);
+	++Metrics.CreatedSessions;
+
+	UE_LOG(LogUEMCPServer, Display, TEXT("MCP session created for client %s (%s)."), *Created.SessionId.ToString(EGuidFormats::DigitsWithHyphens), *Endpoint);
+	return Created;
+}
+
+TArray<TSharedPtr<FUEMCPServerMcpSession>> FUEMCPServerSessionTable::GetSessions() const
+{
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> Result;
+	FReadScopeLock ReadGuard(Lock);
+	Sessions.GenerateValueArray(Result);
+	return Result;
+}
+
+TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerSessionTable::RemoveSession(const FGuid& SessionId)
+{
+	FWriteScopeLock WriteGuard(Lock);
+	TSharedPtr<FUEMCPServerMcpSession> Removed = RemoveSessionLocked(SessionId);
+	if (Removed.IsValid())
+	{
+		++Metrics.ClientTerminations;
+	}
+	return Removed;
+}
+
+TArray<TSharedPtr<FUEMCPServerMcpSession>> FUEMCPServerSessionTable::EvictIdleSessions(double Now)
+{
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> Evicted;
+
+	FWriteScopeLock WriteGuard(Lock);
+	const int64 NowTick = FMath::FloorToInt64(Now / WheelGranularitySeconds);
+
+	// After a long stall every slot is visited once; there is nothing to gain from spinning through the gap.
+	WheelCursor = FMath::Max(WheelCursor, NowTick - UEMCPServer::Sessions::TimerWheelSlots + 1);
+
+	for (; WheelCursor <= NowTick; ++WheelCursor)
+	{
+		TArray<FGuid> Due = MoveTemp(TimerWheel[WheelCursor % UEMCPServer::Sessions::TimerWheelSlots]);
+		TimerWheel[WheelCursor % UEMCPServer::Sessions::TimerWheelSlots].Reset();
+
+		for (const FGuid& SessionId : Due)
+		{
+			const TSharedPtr<FUEMCPServerMcpSession>* Found = Sessions.Find(SessionId);
+			if (!Found)
+			{
+				// Already removed by DELETE or the session cap.
+				continue;
+			}
+
+			const double ExpirySeconds = (*Found)->GetLastActivitySeconds() + IdleTimeoutSeconds;
+			if (ExpirySeconds > Now || (*Found)->HasEventStream())
+			{
+				ScheduleExpiry(SessionId, FMath::Max(ExpirySeconds, Now + WheelGranularitySeconds));
+				continue;
+			}
+
+			UE_LOG(LogUEMCPServer, Display, TEXT("MCP session %s evicted after %.0f seconds idle."),
+				*SessionId.ToString(EGuidFormats::DigitsWithHyphens), Now - (*Found)->GetLastActivitySeconds());
+			Evicted.Add(RemoveSessionLocked(SessionId));
+			++Metrics.IdleEvictions;
+		}
+	}
+
+	return Evicted;
+}
+
+TArray<TSharedPtr<FUEMCPServerMcpSession>> FUEMCPServerSessionTable::RemoveAll()
+{
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> Removed;
+	FWriteScopeLock WriteGuard(Lock);
+	Sessions.GenerateValueArray(Removed);
+	Sessions.Empty();
+	EndpointToSession.Empty();
+	SessionEndpoints.Empty();
+	for (TArray<FGuid>& Slot : TimerWheel)
+	{
+		Slot.Empty();
+	}
+	return Removed;
+}
+
+FUEMCPServerSessionMetrics FUEMCPServerSessionTable::GetMetrics() const
+{
+	FReadScopeLock ReadGuard(Lock);
+	FUEMCPServerSessionMetrics Result = Metrics;
+	Result.LiveSessions = Sessions.Num();
+	return Result;
+}
+
+bool FUEMCPServerSessionTable::IsEndpointMapped(const FString& Endpoint, const FGuid& SessionId) const
+{
+	const FGuid* Mapped = EndpointToSession.Find(Endpoint);
+	return Mapped && *Mapped == SessionId;
+}
+
+void FUEMCPServerSessionTable::MapEndpoint(const FString& Endpoint, const FGuid& SessionId)
+{
+	if (const FGuid* Previous = EndpointToSession.Find(Endpoint))
+	{
+		if (TArray<FString>* PreviousEndpoints = SessionEndpoints.Find(*Previous))
+		{
+			PreviousEndpoints->RemoveSingle(Endpoint);
+		}
+	}
+	EndpointToSession.Add(Endpoint, SessionId);
+
+	// Clients reconnect from fresh ephemeral ports; only the most recent few are worth remembering.
+	TArray<FString>& Endpoints = SessionEndpoints.FindOrAdd(SessionId);
+	Endpoints.Add(Endpoint);
+	while (Endpoints.Num() > UEMCPServer::Sessions::MaxEndpointsPerSession)
+	{
+		EndpointToSession.Remove(Endpoints[0]);
+		Endpoints.RemoveAt(0);
+	}
+}
+
+TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerSessionTable::RemoveSessionLocked(const FGuid& SessionId)
+{
+	TSharedPtr<FUEMCPServerMcpSession> Removed;
+	if (!Sessions.RemoveAndCopyValue(SessionId, Removed))
+	{
+		return nullptr;
+	}
+
+	TArray<FString> Endpoints;
+	if (SessionEndpoints.RemoveAndCopyValue(SessionId, Endpoints))
+	{
+		for (const FString& Endpoint : Endpoints)
+		{
+			EndpointToSession.Remove(Endpoint);
+		}
+	}
+
+	// The timer wheel entry is left behind and skipped when its slot comes due.
+	return Removed;
+}
+
+TSharedPtr<FUEMCPServerMcpSession> FUEMCPServerSessionTable::EvictLeastRecentlyUsedLocked()
+{
+	// Only runs when a new session hits the cap, so a linear scan beats maintaining an LRU list on every request.
+	const FGuid* OldestId = nullptr;
+	double OldestActivity = TNumericLimits<double>::Max();
+	for (const TPair<FGuid, TSharedPtr<FUEMCPServerMcpSession>>& Pair : Sessions)
+	{
+		// A client that only listens on GET looks idle but is live; the idle sweep spares it too.
+		if (Pair.Value->HasEventStream())
+		{
+			continue;
+		}
+
+		const double Activity = Pair.Value->GetLastActivitySeconds();
+		if (Activity < OldestActivity)
+		{
+			OldestActivity = Activity;
+			OldestId = &Pair.Key;
+		}
+	}
+
+	if (!OldestId)
+	{
+		return nullptr;
+	}
+
+	const FGuid EvictedId = *OldestId;
+	UE_LOG(LogUEMCPServer, Display, TEXT("MCP session limit (%d) reached; evicting least recently used session %s."),
+		MaxSessions, *EvictedId.ToString(EGuidFormats::DigitsWithHyphens));
+	++Metrics.CapacityEvictions;
+	return RemoveSessionLocked(EvictedId);
+}
+
+void FUEMCPServerSessionTable::ScheduleExpiry(const FGuid& SessionId, double ExpirySeconds)
+{
+	// Entries beyond the wheel's horizon go in the last reachable slot and are re-slotted when it comes due.
+	const int64 Tick = FMath::Clamp<int64>(
+		FMath::CeilToInt64(ExpirySeconds / WheelGranularitySeconds),
+		WheelCursor + 1,
+		WheelCursor + UEMCPServer::Sessions::TimerWheelSlots - 1);
+	TimerWheel[Tick % UEMCPServer::Sessions::TimerWheelSlots].Add(SessionId);
+}
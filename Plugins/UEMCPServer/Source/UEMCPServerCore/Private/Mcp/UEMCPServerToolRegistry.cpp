@@ -0,0 +1,112 @@
+#include "Mcp/UEMCPServerToolRegistry.h"
+#include "Mcp/UEMCPServerJsonWriter.h"
+#include "Mcp/UEMCPServerMcpSchema.h"
+#include "UEMCPServerLog.h"
+
+#include "Async/Async.h"
+#include "Misc/ScopeRWLock.h"
+
+FUEMCPServerToolResult FUEMCPServerToolResult::Make(TFunctionRef<FString(FUEMCPServerJsonWriter&)> WriteStructured, bool bIsError)
+{
+	FUEMCPServerToolResult Result;
+	Result.bIsError = bIsError;
+
+	FUEMCPServerJsonWriter Writer(Result.StructuredContent);
+	Writer.BeginObject();
+	Result.Message = WriteStructured(Writer);
+	Writer.EndObject();
+	return Result;
+}
+
+FUEMCPServerToolRegistry& FUEMCPServerToolRegistry::Get()
+{
+	static FUEMCPServerToolRegistry Registry;
+	return Registry;
+}
+
+bool FUEMCPServerToolRegistry::RegisterTool(FUEMCPServerToolDefinition&& Definition)
+{
+	if (Definition.Name.IsEmpty() || !Definition.Handler)
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Ignoring MCP tool registration without a name or handler."));
+		return false;
+	}
+
+	const FString Name = Definition.Name;
+	{
+		FWriteScopeLock Guard(ToolsLock);
+		if (Tools.Contains(Name))
+		{
+			UE_LOG(LogUEMCPServer, Warning, TEXT("MCP tool '%s' is already registered."), *Name);
+			return false;
+		}
+		Tools.Add(Name, MakeShared<const FUEMCPServerToolDefinition, ESPMode::ThreadSafe>(MoveTemp(Definition)));
+	}
+
+	UE_LOG(LogUEMCPServer, Verbose, TEXT("Registered MCP tool '%s'."), *Name);
+	UEMCPServerMcpSchema::InvalidateToolsList();
+	return true;
+}
+
+bool FUEMCPServerToolRegistry::UnregisterTool(const FString& Name)
+{
+	{
+		FWriteScopeLock Guard(ToolsLock);
+		if (Tools.Remove(Name) == 0)
+		{
+			return false;
+		}
+	}
+
+	UE_LOG(LogUEMCPServer, Verbose, TEXT("Unregistered MCP tool '%s'."), *Name);
+	UEMCPServerMcpSchema::InvalidateToolsList();
+	return true;
+}
+
+FUEMCPServerToolPtr FUEMCPServerToolRegistry::FindTool(const FString& Name) const
+{
+	FReadScopeLock Guard(ToolsLock);
+	if (const FUEMCPServerToolRef* Tool = Tools.Find(Name))
+	{
+		return *Tool;
+	}
+	return nullptr;
+}
+
+TArray<FUEMCPServerToolRef> FUEMCPServerToolRegistry::GetTools() const
+{
+	TArray<FUEMCPServerToolRef> Result;
+	{
+		FReadScopeLock Guard(ToolsLock);
+		Tools.GenerateValueArray(Result);
+	}
+
+	Result.Sort([](const FUEMCPServerToolRef& A, const FUEMCPServerToolRef& B)
+	{
+		return A->Name.Compare(B->Name, ESearchCase::CaseSensitive) < 0;
+	});
+	return Result;
+}
+
+void FUEMCPServerToolRegistry::InvokeTool(const FUEMCPServerToolRef& Tool, const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)
+{
+	if (Tool->Affinity == EUEMCPServerToolAffinity::GameThread && !IsInGameThread())
+	{
+		AsyncTask(ENamedThreads::GameThread, [Tool, Call, OnComplete = MoveTemp(OnComplete)]() mutable
+		{
+			// The owner may have unregistered the tool (and released what its handler uses) while the hop was queued.
+			if (Get().FindTool(Tool->Name) != Tool)
+			{
+				FUEMCPServerToolResult Result;
+				Result.Message = FString::Printf(TEXT("Tool '%s' is no longer available."), *Tool->Name);
+				Result.bIsError = true;
+				OnComplete(MoveTemp(Result));
+				return;
+			}
+			Tool->Handler(Call, MoveTemp(OnComplete));
+		});
+		return;
+	}
+
+	Tool->Handler(Call, MoveTemp(OnComplete));
+}
@@ -0,0 +1,247 @@
+#include "UEMCPServerCompileDiagnostics.h"
+
+namespace
+{
+	struct FSeverityKeyword
+	{
+		FStringView Text;
+		EUEMCPServerDiagnosticSeverity Severity;
+	};
+
+	/** "fatal error" comes before "error" so the longer keyword wins. */
+	const FSeverityKeyword SeverityKeywords[] =
+	{
+		{ TEXTVIEW("fatal error"), EUEMCPServerDiagnosticSeverity::Error },
+		{ TEXTVIEW("error"), EUEMCPServerDiagnosticSeverity::Error },
+		{ TEXTVIEW("warning"), EUEMCPServerDiagnosticSeverity::Warning },
+	};
+
+	/** Length of the severity keyword Text starts with, if it is followed by ':' or ' '; 0 otherwise. */
+	int32 MatchSeverity(FStringView Text, EUEMCPServerDiagnosticSeverity& OutSeverity)
+	{
+		for (const FSeverityKeyword& Keyword : SeverityKeywords)
+		{
+			const int32 Length = Keyword.Text.Len();
+			if (Text.Len() > Length && Text.StartsWith(Keyword.Text, ESearchCase::IgnoreCase)
+				&& (Text[Length] == TEXT(':') || Text[Length] == TEXT(' ')))
+			{
+				OutSeverity = Keyword.Severity;
+				return Length;
+			}
+		}
+		return 0;
+	}
+
+	bool ParseNumber(FStringView Text, int32& OutValue)
+	{
+		if (Text.IsEmpty() || Text.Len() > 9)
+		{
+			return false;
+		}
+
+		int32 Value = 0;
+		for (const TCHAR Char : Text)
+		{
+			if (!FChar::IsDigit(Char))
+			{
+				return false;
+			}
+			Value = Value * 10 + (Char - TEXT('0'));
+		}
+		OutValue = Value;
+		return true;
+	}
+
+	/** MSVC and UHT: "File(Line)", "File(Line,Col)" or "File(Line,Col-Col)". */
+	bool ParseParenthesisedLocation(FStringView Prefix, FStringView& OutFile, int32& OutLine, int32& OutColumn)
+	{
+		int32 OpenIndex = INDEX_NONE;
+		if (!Prefix.EndsWith(TEXT(')')) || !Prefix.FindLastChar(TEXT('('), OpenIndex))
+		{
+			return false;
+		}
+
+		const FStringView Inside = Prefix.Mid(OpenIndex + 1, Prefix.Len() - OpenIndex - 2);
+		FStringView LineText = Inside;
+		FStringView ColumnText;
+		int32 SeparatorIndex = INDEX_NONE;
+		if (Inside.FindChar(TEXT(','), SeparatorIndex))
+		{
+			LineText = Inside.Left(SeparatorIndex);
+			ColumnText = Inside.RightChop(SeparatorIndex + 1);
+			if (ColumnText.FindChar(TEXT('-'), SeparatorIndex))
+			{
+				ColumnText = ColumnText.Left(SeparatorIndex);
+			}
+		}
+
+		int32 Column = 0;
+		if (!ParseNumber(LineText, OutLine) || (!ColumnText.IsEmpty() && !ParseNumber(ColumnText, Column)))
+		{
+			return false;
+		}
+
+		OutColumn = Column;
+		OutFile = Prefix.Left(OpenIndex).TrimEnd();
+		return !OutFile.IsEmpty();
+	}
+
+	/** clang: "File:Line" or "File:Line:Col"; a drive letter colon is never numeric, so it is left in the file. */
+	bool ParseColonLocation(FStringView Prefix, FStringView& OutFile, int32& OutLine, int32& OutColumn)
+	{
+		int32 ColonIndex = INDEX_NONE;
+		int32 LastNumber = 0;
+		if (!Prefix.FindLastChar(TEXT(':'), ColonIndex) || !ParseNumber(Prefix.RightChop(ColonIndex + 1), LastNumber))
+		{
+			return false;
+		}
+
+		const FStringView Rest = Prefix.Left(ColonIndex);
+		int32 LineNumber = 0;
+		if (Rest.FindLastChar(TEXT(':'), ColonIndex) && ParseNumber(Rest.RightChop(ColonIndex + 1), LineNumber))
+		{
+			OutFile = Rest.Left(ColonIndex);
+			OutLine = LineNumber;
+			OutColumn = LastNumber;
+		}
+		else
+		{
+			OutFile = Rest;
+			OutLine = LastNumber;
+			OutColumn = 0;
+		}
+		return !OutFile.IsEmpty();
+	}
+}
+
+bool FUEMCPServerDiagnosticFilter::Matches(const FUEMCPServerCompileDiagnostic& Diagnostic) const
+{
+	if (Severity.IsSet() && Diagnostic.Severity != Severity.GetValue())
+	{
+		return false;
+	}
+	return File.IsEmpty() || Diagnostic.File.Contains(File, ESearchCase::IgnoreCase);
+}
+
+bool FUEMCPServerCompileDiagnostics::ParseLine(FStringView Message, FUEMCPServerCompileDiagnostic& OutDiagnostic)
+{
+	const FStringView Text = Message.TrimStartAndEnd();
+
+	// The severity either opens the line (UBT) or follows the first ": " that precedes a severity keyword.
+	EUEMCPServerDiagnosticSeverity Severity = EUEMCPServerDiagnosticSeverity::Error;
+	FStringView Prefix;
+	FStringView Rest;
+	if (const int32 KeywordLength = MatchSeverity(Text, Severity))
+	{
+		Rest = Text.RightChop(KeywordLength);
+	}
+	else
+	{
+		for (int32 Index = 0; Index + 2 < Text.Len(); ++Index)
+		{
+			if (Text[Index] == TEXT(':') && Text[Index + 1] == TEXT(' '))
+			{
+				if (const int32 Length = MatchSeverity(Text.RightChop(Index + 2), Severity))
+				{
+					Prefix = Text.Left(Index).TrimEnd();
+					Rest = Text.RightChop(Index + 2 + Length);
+					break;
+				}
+			}
+		}
+
+		if (Rest.IsEmpty())
+		{
+			return false;
+		}
+	}
+
+	FStringView File;
+	int32 Line = 0;
+	int32 Column = 0;
+	const bool bHasLocation = !Prefix.IsEmpty()
+		&& (ParseParenthesisedLocation(Prefix, File, Line, Column) || ParseColonLocation(Prefix, File, Line, Column));
+	if (!bHasLocation)
+	{
+		// Without a location only a single word such as "LINK" or "Module.obj" can name the tool or file.
+		int32 SpaceIndex = INDEX_NONE;
+		if (Prefix.FindChar(TEXT(' '), SpaceIndex))
+		{
+			return false;
+		}
+		File = Prefix.Equals(TEXT("LINK"), ESearchCase::IgnoreCase) ? FStringView() : Prefix;
+	}
+
+	FStringView Code;
+	FStringView Body;
+	if (Rest[0] == TEXT(':'))
+	{
+		Body = Rest.RightChop(1);
+	}
+	else
+	{
+		const FStringView AfterKeyword = Rest.RightChop(1);
+		int32 ColonIndex = INDEX_NONE;
+		int32 SpaceIndex = INDEX_NONE;
+		if (AfterKeyword.FindChar(TEXT(':'), ColonIndex) && ColonIndex > 0 && !AfterKeyword.Left(ColonIndex).FindChar(TEXT(' '), SpaceIndex))
+		{
+			Code = AfterKeyword.Left(ColonIndex);
+			Body = AfterKeyword.RightChop(ColonIndex + 1);
+		}
+		else if (bHasLocation)
+		{
+			Body = AfterKeyword;
+		}
+		else
+		{
+			// Prose such as "Result: error count 3" rather than a diagnostic.
+			return false;
+		}
+	}
+	Body = Body.TrimStartAndEnd();
+
+	// clang names the warning flag at the end: "... [-Wunused-variable]".
+	int32 BracketIndex = INDEX_NONE;
+	if (Code.IsEmpty() && Body.EndsWith(TEXT(']')) && Body.FindLastChar(TEXT('['), BracketIndex) && BracketIndex > 0 && Body[BracketIndex - 1] == TEXT(' '))
+	{
+		Code = Body.Mid(BracketIndex + 1, Body.Len() - BracketIndex - 2);
+		Body = Body.Left(BracketIndex).TrimEnd();
+	}
+
+	OutDiagnostic.Severity = Severity;
+	OutDiagnostic.File = FString(File);
+	OutDiagnostic.File.ReplaceCharInline(TEXT('\\'), TEXT('/'));
+	OutDiagnostic.Line = Line;
+	OutDiagnostic.Column = Column;
+	OutDiagnostic.Code = FString(Code);
+	OutDiagnostic.Message = FString(Body);
+	return true;
+}
+
+bool FUEMCPServerCompileDiagnostics::AddLine(int64 Sequence, FStringView Message)
+{
+	FUEMCPServerCompileDiagnostic Diagnostic;
+	if (!ParseLine(Message, Diagnostic))
+	{
+		return false;
+	}
+
+	Diagnostic.Sequence = Sequence;
+	if (Diagnostic.Severity == EUEMCPServerDiagnosticSeverity::Warning)
+	{
+		++WarningCount;
+	}
+	else
+	{
+		++ErrorCount;
+	}
+	Diagnostics.Add(MoveTemp(Diagnostic));
+	return true;
+}
+
+void FUEMCPServerCompileDiagnostics::Reset()
+{
+	Diagnostics.Reset();
+	ErrorCount = 0;
+	WarningCount = 0;
+}
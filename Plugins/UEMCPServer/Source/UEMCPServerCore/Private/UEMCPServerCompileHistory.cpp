@@ -0,0 +1,523 @@
+#include "UEMCPServerCompileHistory.h"
+#include "UEMCPServerLiveCodingLogBuffer.h"
+#include "UEMCPServerLog.h"
+
+#include "Algo/BinarySearch.h"
+#include "Async/MappedFileHandle.h"
+#include "Containers/StringConv.h"
+#include "HAL/PlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace UEMCPServer::History
+{
+	static constexpr uint32 FileMagic = 0x48434D55; // "UMCH"
+	static constexpr uint32 FileVersion = 1;
+	static constexpr uint32 RecordMagic = 0x52434D55; // "UMCR"
+
+	/** Readers hold a mapping for one tool call at most; an append that finds the file locked waits that long. */
+	static constexpr int32 AppendAttempts = 200;
+	static constexpr float AppendRetrySeconds = 0.01f;
+
+	/** Records rolled out of the history are rewritten away once they outweigh the live ones and this floor. */
+	static constexpr int64 CompactMinDeadBytes = 8 * 1024 * 1024;
+}
+
+/**
+ * File layout: FFileHeader, then records back to back. Each record is an FRecordHeader, the trigger and error
+ * text, a table of FLineRecord and a UTF-8 string blob the lines point into; records are padded to 8 bytes so
+ * every table can be read in place from the mapping.
+ */
+namespace
+{
+	struct FFileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+	};
+
+	struct FRecordHeader
+	{
+		uint32 Magic;
+		uint32 RecordBytes;
+		int64 Id;
+		int64 StartTicks;
+		int64 FinishTicks;
+		int32 NumLines;
+		int32 NumErrors;
+		int32 NumWarnings;
+		uint32 TriggerBytes;
+		uint32 ErrorBytes;
+		uint32 StringBytes;
+		uint8 Result;
+		uint8 Padding[7];
+	};
+	static_assert(sizeof(FRecordHeader) == 64, "History record header layout is part of the file format.");
+
+	struct FLineRecord
+	{
+		int64 Sequence;
+		int64 Ticks;
+		uint32 MessageOffset;
+		uint32 MessageBytes;
+		uint32 CategoryOffset;
+		uint16 CategoryBytes;
+		uint8 Verbosity;
+		uint8 Padding;
+	};
+	static_assert(sizeof(FLineRecord) == 32, "History line layout is part of the file format.");
+
+	int64 LinesOffset(const FRecordHeader& Header)
+	{
+		return Align(static_cast<int64>(sizeof(FRecordHeader)) + Header.TriggerBytes + Header.ErrorBytes, 8);
+	}
+
+	int64 StringsOffset(const FRecordHeader& Header)
+	{
+		return LinesOffset(Header) + static_cast<int64>(Header.NumLines) * sizeof(FLineRecord);
+	}
+
+	/** Validates the record at Data against the bytes left in the file; fills OutHeader on success. */
+	bool ReadRecordHeader(const uint8* Data, int64 Available, FRecordHeader& OutHeader)
+	{
+		if (Available < static_cast<int64>(sizeof(FRecordHeader)))
+		{
+			return false;
+		}
+
+		FMemory::Memcpy(&OutHeader, Data, sizeof(FRecordHeader));
+		return OutHeader.Magic == UEMCPServer::History::RecordMagic
+			&& OutHeader.RecordBytes <= Available
+			&& OutHeader.RecordBytes % 8 == 0
+			&& OutHeader.NumLines >= 0
+			&& StringsOffset(OutHeader) + OutHeader.StringBytes <= OutHeader.RecordBytes;
+	}
+
+	/** True if every line of the record points inside its string blob; the header alone cannot vouch for that. */
+	bool ValidateLineTable(const FRecordHeader& Header, const uint8* Record)
+	{
+		const FLineRecord* Lines = reinterpret_cast<const FLineRecord*>(Record + LinesOffset(Header));
+		const uint64 StringBytes = Header.StringBytes;
+		for (int32 LineIndex = 0; LineIndex < Header.NumLines; ++LineIndex)
+		{
+			const FLineRecord& Line = Lines[LineIndex];
+			if (static_cast<uint64>(Line.MessageOffset) + Line.MessageBytes > StringBytes
+				|| static_cast<uint64>(Line.CategoryOffset) + Line.CategoryBytes > StringBytes)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	FUEMCPServerCompileSummary MakeSummary(const FRecordHeader& Header, const uint8* Record)
+	{
+		FUEMCPServerCompileSummary Summary;
+		Summary.Id = Header.Id;
+		Summary.StartTime = FDateTime(Header.StartTicks);
+		Summary.FinishTime = FDateTime(Header.FinishTicks);
+		Summary.Result = static_cast<ELiveCodingCompileResult>(Header.Result);
+		Summary.TriggerSource = FString(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Record + sizeof(FRecordHeader)), Header.TriggerBytes));
+		Summary.NumLines = Header.NumLines;
+		Summary.NumErrors = Header.NumErrors;
+		Summary.NumWarnings = Header.NumWarnings;
+		return Summary;
+	}
+
+	uint32 AppendUtf8(TArray<uint8>& Blob, FUtf8StringView Text)
+	{
+		const uint32 Offset = Blob.Num();
+		Blob.Append(reinterpret_cast<const uint8*>(Text.GetData()), Text.Len());
+		return Offset;
+	}
+}
+
+/** A read-only mapping of the whole history file as it was when mapped. */
+struct FUEMCPServerHistoryMapping
+{
+	// Declared in this order so the region is unmapped before its file handle is closed.
+	TUniquePtr<IMappedFileHandle> Handle;
+	TUniquePtr<IMappedFileRegion> Region;
+
+	const uint8* GetData() const { return Region->GetMappedPtr(); }
+	int64 GetSize() const { return Region->GetMappedSize(); }
+};
+
+int64 FUEMCPServerCompileRecord::GetSequence(int32 Index) const
+{
+	return reinterpret_cast<const FLineRecord*>(Lines)[Index].Sequence;
+}
+
+FDateTime FUEMCPServerCompileRecord::GetTimestamp(int32 Index) const
+{
+	return FDateTime(reinterpret_cast<const FLineRecord*>(Lines)[Index].Ticks);
+}
+
+ELogVerbosity::Type FUEMCPServerCompileRecord::GetVerbosity(int32 Index) const
+{
+	return static_cast<ELogVerbosity::Type>(reinterpret_cast<const FLineRecord*>(Lines)[Index].Verbosity);
+}
+
+FUtf8StringView FUEMCPServerCompileRecord::GetCategory(int32 Index) const
+{
+	const FLineRecord& Line = reinterpret_cast<const FLineRecord*>(Lines)[Index];
+	return FUtf8StringView(Strings + Line.CategoryOffset, Line.CategoryBytes);
+}
+
+FUtf8StringView FUEMCPServerCompileRecord::GetMessage(int32 Index) const
+{
+	const FLineRecord& Line = reinterpret_cast<const FLineRecord*>(Lines)[Index];
+	return FUtf8StringView(Strings + Line.MessageOffset, Line.MessageBytes);
+}
+
+FUEMCPServerLogPage FUEMCPServerCompileRecord::SelectPage(const FUEMCPServerLogQuery& Query) const
+{
+	const TConstArrayView<FLineRecord> LineTable(reinterpret_cast<const FLineRecord*>(Lines), Summary.NumLines);
+	const int32 FirstUnseen = Algo::UpperBoundBy(LineTable, Query.SinceSequence, &FLineRecord::Sequence);
+	return UEMCPServer::SelectLogPage(Query, Summary.NumLines, FirstUnseen, [&LineTable](int32 Index)
+	{
+		return LineTable[Index].Sequence;
+	});
+}
+
+FUEMCPServerCompileHistory::FUEMCPServerCompileHistory(FString InFilename, int32 InCapacity)
+	: Filename(MoveTemp(InFilename))
+	, Capacity(FMath::Max(InCapacity, 1))
+{
+}
+
+FUEMCPServerCompileHistory::~FUEMCPServerCompileHistory() = default;
+
+void FUEMCPServerCompileHistory::Open()
+{
+	FScopeLock Lock(&Mutex);
+	Index.Reset();
+	Mapping.Reset();
+	FileSize = 0;
+	NextId = 1;
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*FPaths::GetPath(Filename));
+
+	const int64 ExistingSize = PlatformFile.FileSize(*Filename);
+	if (ExistingSize <= 0)
+	{
+		return;
+	}
+
+	FileSize = ExistingSize;
+	TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> FileMapping = GetMapping();
+
+	bool bNeedsRewrite = true;
+	int64 ValidBytes = 0;
+	TArray<FIndexEntry> Scanned;
+	if (FileMapping.IsValid() && FileMapping->GetSize() >= static_cast<int64>(sizeof(FFileHeader)))
+	{
+		const uint8* Data = FileMapping->GetData();
+		FFileHeader FileHeader;
+		FMemory::Memcpy(&FileHeader, Data, sizeof(FFileHeader));
+		if (FileHeader.Magic == UEMCPServer::History::FileMagic && FileHeader.Version == UEMCPServer::History::FileVersion)
+		{
+			int64 Offset = sizeof(FFileHeader);
+			FRecordHeader Header;
+			while (ReadRecordHeader(Data + Offset, FileMapping->GetSize() - Offset, Header))
+			{
+				FIndexEntry& Entry = Scanned.AddDefaulted_GetRef();
+				Entry.Summary = MakeSummary(Header, Data + Offset);
+				Entry.Offset = Offset;
+				Entry.Bytes = Header.RecordBytes;
+				Offset += Header.RecordBytes;
+			}
+			ValidBytes = Offset;
+			bNeedsRewrite = ValidBytes != FileMapping->GetSize() || Scanned.Num() > Capacity;
+		}
+	}
+
+	if (!bNeedsRewrite)
+	{
+		Index = MoveTemp(Scanned);
+		NextId = Index.IsEmpty() ? 1 : Index.Last().Summary.Id + 1;
+		return;
+	}
+
+	// Keep the newest Capacity intact records and drop the rest, including any record torn by a crash mid-append.
+	NextId = Scanned.IsEmpty() ? 1 : Scanned.Last().Summary.Id + 1;
+	Scanned.RemoveAt(0, FMath::Max(Scanned.Num() - Capacity, 0));
+	const TArray<uint8> Compacted = BuildCompacted(FileMapping.IsValid() ? FileMapping->GetData() : nullptr, Scanned);
+	Index = MoveTemp(Scanned);
+
+	FileMapping.Reset();
+	Mapping.Reset();
+
+	if (!ReplaceFileLocked(Compacted))
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Could not compact compile history %s; history starts empty."), *Filename);
+		Index.Reset();
+		FileSize = 0;
+		PlatformFile.DeleteFile(*Filename);
+		return;
+	}
+	FileSize = Compacted.Num();
+
+	UE_LOG(LogUEMCPServer, Verbose, TEXT("Compacted compile history %s to %d record(s)."), *Filename, Index.Num());
+}
+
+int64 FUEMCPServerCompileHistory::Append(FUEMCPServerCompileSummary Summary, FStringView ErrorMessage, const FUEMCPServerLiveCodingLogBuffer& Log)
+{
+	const FTCHARToUTF8 TriggerUtf8(*Summary.TriggerSource, Summary.TriggerSource.Len());
+	const FTCHARToUTF8 ErrorUtf8(ErrorMessage.GetData(), ErrorMessage.Len());
+
+	// Categories repeat on almost every line, so each is written to the blob once.
+	TArray<FLineRecord> Lines;
+	Lines.SetNumZeroed(Log.Num());
+	TArray<uint8> Strings;
+	TMap<FName, TPair<uint32, uint16>> CategoryStrings;
+	for (int32 LineIndex = 0; LineIndex < Log.Num(); ++LineIndex)
+	{
+		const FName Category = Log.GetCategory(LineIndex);
+		TPair<uint32, uint16>* CategoryString = CategoryStrings.Find(Category);
+		if (!CategoryString)
+		{
+			const FTCHARToUTF8 CategoryUtf8(*Category.ToString());
+			const uint16 CategoryBytes = static_cast<uint16>(FMath::Min(CategoryUtf8.Length(), static_cast<int32>(MAX_uint16)));
+			const uint32 CategoryOffset = AppendUtf8(Strings, FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(CategoryUtf8.Get()), CategoryBytes));
+			CategoryString = &CategoryStrings.Add(Category, { CategoryOffset, CategoryBytes });
+		}
+
+		FLineRecord& Line = Lines[LineIndex];
+		Line.Sequence = Log.GetSequence(LineIndex);
+		Line.Ticks = Log.GetTimestamp(LineIndex).GetTicks();
+		Line.MessageBytes = Log.GetMessage(LineIndex).Len();
+		Line.MessageOffset = AppendUtf8(Strings, Log.GetMessage(LineIndex));
+		Line.CategoryOffset = CategoryString->Key;
+		Line.CategoryBytes = CategoryString->Value;
+		Line.Verbosity = static_cast<uint8>(Log.GetVerbosity(LineIndex));
+	}
+	Summary.NumLines = Log.Num();
+
+	FRecordHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = UEMCPServer::History::RecordMagic;
+	Header.StartTicks = Summary.StartTime.GetTicks();
+	Header.FinishTicks = Summary.FinishTime.GetTicks();
+	Header.NumLines = Summary.NumLines;
+	Header.NumErrors = Summary.NumErrors;
+	Header.NumWarnings = Summary.NumWarnings;
+	Header.TriggerBytes = TriggerUtf8.Length();
+	Header.ErrorBytes = ErrorUtf8.Length();
+	Header.StringBytes = Strings.Num();
+	Header.Result = static_cast<uint8>(Summary.Result);
+
+	const int64 RecordBytes = Align(StringsOffset(Header) + Header.StringBytes, 8);
+	if (RecordBytes > MAX_int32)
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Compile log of %d lines is too large for the compile history; not archived."), Summary.NumLines);
+		return 0;
+	}
+	Header.RecordBytes = static_cast<uint32>(RecordBytes);
+
+	TArray<uint8> Record;
+	Record.SetNumZeroed(RecordBytes);
+	uint8* Cursor = Record.GetData();
+	FMemory::Memcpy(Cursor + sizeof(FRecordHeader), TriggerUtf8.Get(), Header.TriggerBytes);
+	FMemory::Memcpy(Cursor + sizeof(FRecordHeader) + Header.TriggerBytes, ErrorUtf8.Get(), Header.ErrorBytes);
+	FMemory::Memcpy(Cursor + LinesOffset(Header), Lines.GetData(), Lines.Num() * sizeof(FLineRecord));
+	FMemory::Memcpy(Cursor + StringsOffset(Header), Strings.GetData(), Strings.Num());
+
+	// Drop our own mapping first; some platforms refuse to write a file that is mapped. The file is opened, and
+	// waited for, without holding Mutex so readers are never stuck behind the retries.
+	{
+		FScopeLock Lock(&Mutex);
+		Mapping.Reset();
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TUniquePtr<IFileHandle> FileHandle;
+	for (int32 Attempt = 0; Attempt < UEMCPServer::History::AppendAttempts && !FileHandle.IsValid(); ++Attempt)
+	{
+		FileHandle.Reset(PlatformFile.OpenWrite(*Filename, /*bAppend=*/true, /*bAllowRead=*/true));
+		if (!FileHandle.IsValid())
+		{
+			FPlatformProcess::Sleep(UEMCPServer::History::AppendRetrySeconds);
+		}
+	}
+
+	FScopeLock Lock(&Mutex);
+	Header.Id = NextId;
+	FMemory::Memcpy(Cursor, &Header, sizeof(FRecordHeader));
+
+	const bool bWriteFileHeader = FileSize == 0;
+	const FFileHeader FileHeader = { UEMCPServer::History::FileMagic, UEMCPServer::History::FileVersion };
+
+	// A mapping made while the handle was being opened covers only the old size.
+	Mapping.Reset();
+
+	const bool bWritten = FileHandle.IsValid()
+		&& (!bWriteFileHeader || FileHandle->Write(reinterpret_cast<const uint8*>(&FileHeader), sizeof(FFileHeader)))
+		&& FileHandle->Write(Record.GetData(), Record.Num());
+	FileHandle.Reset();
+
+	if (!bWritten)
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Could not append to compile history %s."), *Filename);
+		// A partial write leaves a torn tail that the next Open trims; the size on disk is the truth from here on.
+		FileSize = FMath::Max<int64>(PlatformFile.FileSize(*Filename), 0);
+		return 0;
+	}
+
+	FIndexEntry& Entry = Index.AddDefaulted_GetRef();
+	Summary.Id = Header.Id;
+	Entry.Summary = MoveTemp(Summary);
+	Entry.Offset = FileSize + (bWriteFileHeader ? sizeof(FFileHeader) : 0);
+	Entry.Bytes = RecordBytes;
+	FileSize = Entry.Offset + RecordBytes;
+	++NextId;
+
+	if (Index.Num() > Capacity)
+	{
+		Index.RemoveAt(0, Index.Num() - Capacity);
+		CompactIfWastefulLocked();
+	}
+	return Header.Id;
+}
+
+void FUEMCPServerCompileHistory::CompactIfWastefulLocked()
+{
+	int64 LiveBytes = 0;
+	for (const FIndexEntry& Entry : Index)
+	{
+		LiveBytes += Entry.Bytes;
+	}
+
+	const int64 DeadBytes = FileSize - static_cast<int64>(sizeof(FFileHeader)) - LiveBytes;
+	if (DeadBytes < UEMCPServer::History::CompactMinDeadBytes || DeadBytes < LiveBytes)
+	{
+		return;
+	}
+
+	TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> FileMapping = GetMapping();
+	if (!FileMapping.IsValid() || FileMapping->GetSize() < FileSize)
+	{
+		return;
+	}
+
+	TArray<FIndexEntry> Compacted = Index;
+	const TArray<uint8> Contents = BuildCompacted(FileMapping->GetData(), Compacted);
+	FileMapping.Reset();
+	Mapping.Reset();
+
+	// Records handed out still map the old file; if that keeps it from being replaced, the next append tries again.
+	if (ReplaceFileLocked(Contents))
+	{
+		Index = MoveTemp(Compacted);
+		FileSize = Contents.Num();
+		UE_LOG(LogUEMCPServer, Verbose, TEXT("Compacted compile history %s, dropping %lld bytes of rolled-out records."), *Filename, DeadBytes);
+	}
+}
+
+TArray<uint8> FUEMCPServerCompileHistory::BuildCompacted(const uint8* Data, TArray<FIndexEntry>& InOutEntries)
+{
+	TArray<uint8> Contents;
+	const FFileHeader FileHeader = { UEMCPServer::History::FileMagic, UEMCPServer::History::FileVersion };
+	Contents.Append(reinterpret_cast<const uint8*>(&FileHeader), sizeof(FFileHeader));
+	for (FIndexEntry& Entry : InOutEntries)
+	{
+		const int64 NewOffset = Contents.Num();
+		Contents.Append(Data + Entry.Offset, Entry.Bytes);
+		Entry.Offset = NewOffset;
+	}
+	return Contents;
+}
+
+bool FUEMCPServerCompileHistory::ReplaceFileLocked(const TArray<uint8>& Contents) const
+{
+	// Written beside the history and moved over it, so a crash mid-write never loses the old file.
+	const FString TempFilename = Filename + TEXT(".tmp");
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	if (!FFileHelper::SaveArrayToFile(Contents, *TempFilename))
+	{
+		return false;
+	}
+
+	if ((PlatformFile.FileExists(*Filename) && !PlatformFile.DeleteFile(*Filename)) || !PlatformFile.MoveFile(*Filename, *TempFilename))
+	{
+		PlatformFile.DeleteFile(*TempFilename);
+		return false;
+	}
+	return true;
+}
+
+TArray<FUEMCPServerCompileSummary> FUEMCPServerCompileHistory::GetSummaries(int32 MaxCount) const
+{
+	FScopeLock Lock(&Mutex);
+	TArray<FUEMCPServerCompileSummary> Summaries;
+	Summaries.Reserve(FMath::Clamp(MaxCount, 0, Index.Num()));
+	for (int32 EntryIndex = Index.Num() - 1; EntryIndex >= 0 && Summaries.Num() < MaxCount; --EntryIndex)
+	{
+		Summaries.Add(Index[EntryIndex].Summary);
+	}
+	return Summaries;
+}
+
+FUEMCPServerCompileRecordPtr FUEMCPServerCompileHistory::FindRecord(int64 Id) const
+{
+	FScopeLock Lock(&Mutex);
+	const int32 EntryIndex = Algo::BinarySearchBy(Index, Id, [](const FIndexEntry& Entry) { return Entry.Summary.Id; });
+	if (EntryIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	const FIndexEntry& Entry = Index[EntryIndex];
+	TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> FileMapping = GetMapping();
+	if (!FileMapping.IsValid() || Entry.Offset + Entry.Bytes > FileMapping->GetSize())
+	{
+		return nullptr;
+	}
+
+	const uint8* Data = FileMapping->GetData() + Entry.Offset;
+	FRecordHeader Header;
+	if (!ReadRecordHeader(Data, Entry.Bytes, Header) || !ValidateLineTable(Header, Data))
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Archived compile %lld in %s is corrupt."), Id, *Filename);
+		return nullptr;
+	}
+
+	TSharedRef<FUEMCPServerCompileRecord, ESPMode::ThreadSafe> Record = MakeShared<FUEMCPServerCompileRecord, ESPMode::ThreadSafe>();
+	Record->Mapping = FileMapping;
+	Record->Lines = Data + LinesOffset(Header);
+	Record->Strings = reinterpret_cast<const UTF8CHAR*>(Data + StringsOffset(Header));
+	Record->ErrorMessage = FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(Data + sizeof(FRecordHeader) + Header.TriggerBytes), Header.ErrorBytes);
+	Record->Summary = Entry.Summary;
+	return Record;
+}
+
+TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> FUEMCPServerCompileHistory::GetMapping() const
+{
+	if (Mapping.IsValid() || FileSize <= 0)
+	{
+		return Mapping;
+	}
+
+	TSharedRef<FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> NewMapping = MakeShared<FUEMCPServerHistoryMapping, ESPMode::ThreadSafe>();
+	FOpenMappedResult OpenResult = FPlatformFileManager::Get().GetPlatformFile().OpenMappedEx(*Filename);
+	if (OpenResult.HasError())
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Could not map compile history %s: %s"), *Filename, *OpenResult.GetError().GetMessage());
+		return nullptr;
+	}
+	NewMapping->Handle = OpenResult.StealValue();
+
+	NewMapping->Region.Reset(NewMapping->Handle->MapRegion(0, FileSize));
+	if (!NewMapping->Region.IsValid())
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Could not map %lld bytes of compile history %s."), FileSize, *Filename);
+		return nullptr;
+	}
+
+	Mapping = NewMapping;
+	return Mapping;
+}
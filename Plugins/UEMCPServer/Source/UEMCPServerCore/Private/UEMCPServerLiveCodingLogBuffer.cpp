@@ -0,0 +1,100 @@
+#include "UEMCPServerLiveCodingLogBuffer.h"
+
+#include "Algo/BinarySearch.h"
+#include "Containers/StringConv.h"
+
+namespace UEMCPServer::LiveCoding
+{
+	/** Arena chunk size; a chunk holds a few hundred typical compiler lines. */
+	static constexpr int32 LogArenaChunkBytes = 64 * 1024;
+}
+
+void FUEMCPServerLiveCodingLogBuffer::Add(int64 Sequence, FName Category, ELogVerbosity::Type Verbosity, const FDateTime& Timestamp, FStringView Message)
+{
+	checkSlow(Sequences.IsEmpty() || Sequences.Last() < Sequence);
+
+	const FTCHARToUTF8 MessageUtf8(Message.GetData(), Message.Len());
+
+	Sequences.Add(Sequence);
+	TimestampTicks.Add(Timestamp.GetTicks());
+	Categories.Add(Category);
+	Verbosities.Add(static_cast<uint8>(Verbosity & ELogVerbosity::VerbosityMask));
+	Messages.Add(AppendToArena(FUtf8StringView(reinterpret_cast<const UTF8CHAR*>(MessageUtf8.Get()), MessageUtf8.Length())));
+}
+
+void FUEMCPServerLiveCodingLogBuffer::Reset()
+{
+	Sequences.Empty();
+	TimestampTicks.Empty();
+	Categories.Empty();
+	Verbosities.Empty();
+	Messages.Empty();
+	Chunks.Empty();
+}
+
+int32 FUEMCPServerLiveCodingLogBuffer::FindFirstAfter(int64 Sequence) const
+{
+	return Algo::UpperBound(Sequences, Sequence);
+}
+
+FUEMCPServerLogPage FUEMCPServerLiveCodingLogBuffer::SelectPage(const FUEMCPServerLogQuery& Query) const
+{
+	return UEMCPServer::SelectLogPage(Query, Num(), FindFirstAfter(Query.SinceSequence), [this](int32 Index)
+	{
+		return Sequences[Index];
+	});
+}
+
+FUEMCPServerLogEntry FUEMCPServerLiveCodingLogBuffer::MakeEntry(int32 Index) const
+{
+	FUEMCPServerLogEntry Entry;
+	Entry.Sequence = Sequences[Index];
+	Entry.Message = FString(Messages[Index]);
+	Entry.Category = Categories[Index];
+	Entry.Verbosity = GetVerbosity(Index);
+	Entry.Timestamp = GetTimestamp(Index);
+	return Entry;
+}
+
+SIZE_T FUEMCPServerLiveCodingLogBuffer::GetAllocatedSize() const
+{
+	SIZE_T Size = Sequences.GetAllocatedSize() + TimestampTicks.GetAllocatedSize() + Categories.GetAllocatedSize()
+		+ Verbosities.GetAllocatedSize() + Messages.GetAllocatedSize() + Chunks.GetAllocatedSize();
+	for (const FChunk& Chunk : Chunks)
+	{
+		Size += Chunk.Data.GetAllocatedSize();
+	}
+	return Size;
+}
+
+FUtf8StringView FUEMCPServerLiveCodingLogBuffer::AppendToArena(FUtf8StringView Text)
+{
+	const int32 Length = Text.Len();
+	if (Length == 0)
+	{
+		return FUtf8StringView();
+	}
+
+	const int32 ChunkBytes = UEMCPServer::LiveCoding::LogArenaChunkBytes;
+	if (Length > ChunkBytes / 4)
+	{
+		// Oversized lines get a chunk of their own, slotted in before the open chunk so its free tail stays in use.
+		FChunk OwnChunk;
+		OwnChunk.Data.Reserve(Length);
+		OwnChunk.Data.Append(Text.GetData(), Length);
+		const FUtf8StringView Copy(OwnChunk.Data.GetData(), Length);
+		Chunks.Insert(MoveTemp(OwnChunk), FMath::Max(Chunks.Num() - 1, 0));
+		return Copy;
+	}
+
+	if (Chunks.IsEmpty() || Chunks.Last().Data.Max() - Chunks.Last().Data.Num() < Length)
+	{
+		Chunks.AddDefaulted_GetRef().Data.Reserve(ChunkBytes);
+	}
+
+	// Chunks never grow past their reserve, so views into them stay valid as the arena fills.
+	TArray<UTF8CHAR>& Chunk = Chunks.Last().Data;
+	const int32 Offset = Chunk.Num();
+	Chunk.Append(Text.GetData(), Length);
+	return FUtf8StringView(Chunk.GetData() + Offset, Length);
+}
@@ -1,9 +1,17 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UEMCPServerCompileHistory.h"
+#include "UEMCPServerCompileSnapshot.h"
 #include "UEMCPServerLiveCodingTypes.h"
 #include "ILiveCodingModule.h"
 
+/** Broadcast on the game thread once a compile has been finalized and its snapshot published. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FUEMCPServerOnCompileFinished, ELiveCodingCompileResult /*Result*/);
+
+/** Broadcast on the game thread with small batches of log lines, in sequence order, while a compile runs. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FUEMCPServerOnCompileLog, TConstArrayView<FUEMCPServerLogEntry> /*Entries*/);
+
 /**
  * Interface for providing Live Coding functionality to the MCP server.
  */
@@ -12,12 +20,21 @@ class UEMCPSERVERCORE_API IUEMCPServerLiveCodingProvider
 public:
 	virtual ~IUEMCPServerLiveCodingProvider() = default;
 
-	/** Attempts to begin a compile; returns false if one is already running or setup failed. */
-	virtual bool TryBeginCompile(FString& OutErrorMessage) = 0;
+	/** Attempts to begin a compile; returns false if one is already running or setup failed. TriggerSource is archived with it. */
+	virtual bool TryBeginCompile(const FString& TriggerSource, FString& OutErrorMessage) = 0;
 
-	/** Executes the Live Coding compile synchronously. Must be called on the game thread. */
+	/** Starts the Live Coding compile; it finishes later, announced by OnCompileFinished. Must be called on the game thread. */
 	virtual void ExecuteCompileOnGameThread() = 0;
 
-	/** Retrieves the latest compile snapshot and status information. */
-	virtual void GetLastCompileSnapshot(TArray<FUEMCPServerLogEntry>& OutEntries, FDateTime& OutTimestamp, ELiveCodingCompileResult& OutResult, bool& bOutHasResult, FString& OutErrorMessage, bool& bOutIsInProgress) const = 0;
+	/** The latest published compile snapshot; safe to call from any thread and to hold for as long as needed. */
+	virtual FUEMCPServerCompileSnapshotRef GetLastCompileSnapshot() const = 0;
+
+	/** Archive of recent compiles, or null when the history is disabled. */
+	virtual const FUEMCPServerCompileHistory* GetCompileHistory() const = 0;
+
+	/** Event raised whenever a compile finishes, successfully or not. */
+	virtual FUEMCPServerOnCompileFinished& OnCompileFinished() = 0;
+
+	/** Event raised with captured log lines as they arrive; every batch precedes the compile's finish event. */
+	virtual FUEMCPServerOnCompileLog& OnCompileLog() = 0;
 };
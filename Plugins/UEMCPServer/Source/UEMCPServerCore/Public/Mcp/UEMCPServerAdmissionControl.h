@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Guid.h"
+#include "Templates/Atomic.h"
+
+struct FUEMCPServerMcpServerSettings;
+
+/** Classic token bucket; refilled lazily from the time of the last take. */
+struct FUEMCPServerTokenBucket
+{
+	double Tokens = 0.0;
+	double LastRefillSeconds = -1.0;
+
+	/** Takes Cost tokens, or returns false and the seconds until that many will have accrued. */
+	bool TryConsume(double Rate, double Burst, double Cost, double Now, double& OutRetryAfterSeconds);
+};
+
+enum class EUEMCPServerAdmission : uint8
+{
+	Admitted,
+	TooManyInFlight,
+	SessionRateLimited,
+	GlobalRateLimited,
+};
+
+struct FUEMCPServerAdmissionMetrics
+{
+	int32 InFlight = 0;
+	uint64 Admitted = 0;
+	uint64 RejectedInFlight = 0;
+	uint64 RejectedSessionRate = 0;
+	uint64 RejectedGlobalRate = 0;
+};
+
+/**
+ * Per-session and global request rate limits plus a cap on POST requests in flight. Shared by reference with
+ * pending completions so a request finishing after the server stopped can still release its slot.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerAdmissionControl
+{
+public:
+	explicit FUEMCPServerAdmissionControl(const FUEMCPServerMcpServerSettings& Settings);
+
+	/**
+	 * Admits a POST before its body is copied or parsed: takes an in-flight slot and one token from each bucket.
+	 * SessionId is invalid for a request not yet bound to a session, which only the global bucket is charged for.
+	 * On success the caller must call Release once it has answered.
+	 */
+	EUEMCPServerAdmission TryAdmit(const FGuid& SessionId, double& OutRetryAfterSeconds);
+
+	/** Charges an admitted batch for its messages beyond the first; on failure the caller still has to Release. */
+	EUEMCPServerAdmission TryChargeMessages(const FGuid& SessionId, int32 MessageCount, double& OutRetryAfterSeconds);
+
+	void Release();
+
+	/** Drops the bucket of a session that left the session table. */
+	void ForgetSession(const FGuid& SessionId);
+
+	FUEMCPServerAdmissionMetrics GetMetrics() const;
+
+private:
+	/** Takes Cost tokens from both buckets, or from neither; callers hold BucketMutex. */
+	EUEMCPServerAdmission ConsumeLocked(const FGuid& SessionId, double Cost, double& OutRetryAfterSeconds);
+
+	double SessionRate;
+	double SessionBurst;
+	double GlobalRate;
+	double GlobalBurst;
+	int32 MaxInFlight;
+
+	TAtomic<int32> InFlight;
+
+	mutable FCriticalSection BucketMutex;
+	FUEMCPServerTokenBucket GlobalBucket;
+	TMap<FGuid, FUEMCPServerTokenBucket> SessionBuckets;
+	FUEMCPServerAdmissionMetrics Metrics;
+};
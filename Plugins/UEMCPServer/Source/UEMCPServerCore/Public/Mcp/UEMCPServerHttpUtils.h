@@ -3,17 +3,94 @@
 #include "CoreMinimal.h"
 #include "HttpServerRequest.h"
 
-class FJsonObject;
+struct FUEMCPServerMcpPayload;
+
+/**
+ * Headers of one request, normalized once: names are lowercased into a hashed map and the MCP headers are resolved
+ * up front, so handlers and log lines read them without rescanning the raw header map.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerRequestHeaders
+{
+public:
+	explicit FUEMCPServerRequestHeaders(const TMap<FString, TArray<FString>>& RawHeaders);
+
+	const FString& GetAccept() const { return Accept; }
+	const FString& GetProtocolVersion() const { return ProtocolVersion; }
+	const FString& GetSessionId() const { return SessionId; }
+	const FString& GetLastEventId() const { return LastEventId; }
+	const FString& GetAcceptEncoding() const { return AcceptEncoding; }
+
+	/** First non-empty value of the named header, or an empty string. Name is matched case-insensitively, without a copy. */
+	const FString& Find(FStringView Name) const;
+
+private:
+	TMap<FString, FString> Values;
+	FString Accept;
+	FString ProtocolVersion;
+	FString SessionId;
+	FString LastEventId;
+	FString AcceptEncoding;
+};
+
+enum class EUEMCPServerRepresentation : uint8
+{
+	None,
+	Json,
+	EventStream,
+};
+
+/** Qualities, in thousandths, that a client's Accept header gives the two MCP response representations. */
+struct FUEMCPServerAcceptPreferences
+{
+	uint16 JsonQuality = 0;
+	uint16 EventStreamQuality = 0;
+
+	bool AcceptsJson() const { return JsonQuality > 0; }
+	bool AcceptsEventStream() const { return EventStreamQuality > 0; }
+
+	/** The representation to use when both would do; JSON wins ties. */
+	EUEMCPServerRepresentation GetPreferred() const
+	{
+		if (!AcceptsJson() && !AcceptsEventStream())
+		{
+			return EUEMCPServerRepresentation::None;
+		}
+		return JsonQuality >= EventStreamQuality ? EUEMCPServerRepresentation::Json : EUEMCPServerRepresentation::EventStream;
+	}
+};
 
 class UEMCPSERVERCORE_API UEMCPServerHttpUtils
 {
 public:
-	static FString RequestBodyToString(const FHttpServerRequest& Request);
 	static FString PeerEndpointString(const TSharedPtr<FInternetAddr>& PeerAddress);
-	static bool ContainsToken(const FString& Source, const FString& Token);
-	static TSharedPtr<FJsonObject> ParseJsonObject(const FString& Body);
+
+	/** Parses an RFC 9110 qvalue ("0", "0.5", "1.000") into thousandths; malformed values count as 1. */
+	static uint16 ParseQuality(FStringView Value);
+
+	/**
+	 * Pops the next element of a comma-separated header list such as Accept or Accept-Encoding without allocating.
+	 * OutToken is the trimmed element without parameters and OutQuality its q parameter in thousandths.
+	 */
+	static bool NextListElement(FStringView& List, FStringView& OutToken, uint16& OutQuality);
+
+	/** Negotiates a POST response representation from an Accept header; repeated headers are served from a small cache. */
+	static FUEMCPServerAcceptPreferences NegotiateAccept(FStringView Accept);
+	static bool ParseMcpPayload(const TArray<uint8>& Utf8Body, FUEMCPServerMcpPayload& OutPayload);
 	static FString MakeLogContext(const TCHAR* Phase, const FString& Endpoint, const FGuid& SessionId, const FString& Method, const FString& Accept);
-	static void AppendSseEvent(FString& Output, const FString& Message);
-	static FString ExtractHeaderValue(const TMap<FString, TArray<FString>>& Headers, const FString& HeaderName);
+
+	/**
+	 * Frames a UTF-8 message as one Server-Sent Event, scanning it once: every line becomes a "data:" line, so
+	 * embedded CR, LF and CRLF breaks survive the round trip. The "id:" line is written when EventId is not negative.
+	 */
+	static void AppendSseEvent(TArray<uint8>& Output, TConstArrayView<uint8> Utf8Message, int64 EventId = INDEX_NONE);
+
+	/** Appends an SSE comment line, ignored by clients; used as a heartbeat. */
+	static void AppendSseComment(TArray<uint8>& Output, FAnsiStringView Comment);
+
+	/** Appends an SSE "retry:" field, the delay a client waits before reconnecting once the stream ends. */
+	static void AppendSseRetry(TArray<uint8>& Output, int32 RetryMilliseconds);
+
+	/** Bytes an event adds around a single-line message, for presizing a buffer that holds several events. */
+	static constexpr int32 SseEventOverhead = 32;
 	static bool TryParseSessionId(const FString& RawValue, FGuid& OutSessionId);
 };
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+class FJsonValue;
+
+/**
+ * Forward-only JSON writer that emits condensed UTF-8 straight into a caller-owned byte buffer.
+ * Used for MCP replies so responses never round-trip through a JSON DOM or a TCHAR string.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerJsonWriter
+{
+public:
+	explicit FUEMCPServerJsonWriter(TArray<uint8>& InBuffer);
+
+	void BeginObject();
+	void BeginObject(FAnsiStringView Key);
+	void EndObject();
+
+	void BeginArray();
+	void BeginArray(FAnsiStringView Key);
+	void EndArray();
+
+	void WriteKey(FAnsiStringView Key);
+	void WriteKey(FStringView Key);
+
+	void WriteString(FAnsiStringView Value);
+	void WriteString(FStringView Value);
+	void WriteString(FUtf8StringView Value);
+	void WriteBool(bool bValue);
+	void WriteInt(int64 Value);
+	void WriteDouble(double Value);
+	void WriteNull();
+	void WriteIso8601(const FDateTime& Value);
+
+	/** Writes an already serialized JSON value verbatim. */
+	void WriteRaw(TConstArrayView<uint8> Json);
+
+	/** Writes a JSON DOM value; kept for the few places that still carry client supplied DOM (ids, error data). */
+	void WriteJsonValue(const TSharedPtr<FJsonValue>& Value);
+	void WriteJsonObject(const TSharedPtr<FJsonObject>& Object);
+
+	void WriteStringField(FAnsiStringView Key, FAnsiStringView Value) { WriteKey(Key); WriteString(Value); }
+	void WriteStringField(FAnsiStringView Key, FStringView Value) { WriteKey(Key); WriteString(Value); }
+	void WriteStringField(FAnsiStringView Key, FUtf8StringView Value) { WriteKey(Key); WriteString(Value); }
+	void WriteBoolField(FAnsiStringView Key, bool bValue) { WriteKey(Key); WriteBool(bValue); }
+	void WriteIntField(FAnsiStringView Key, int64 Value) { WriteKey(Key); WriteInt(Value); }
+	void WriteDoubleField(FAnsiStringView Key, double Value) { WriteKey(Key); WriteDouble(Value); }
+	void WriteNullField(FAnsiStringView Key) { WriteKey(Key); WriteNull(); }
+	void WriteIso8601Field(FAnsiStringView Key, const FDateTime& Value) { WriteKey(Key); WriteIso8601(Value); }
+
+private:
+	void BeginValue();
+	void BeginKey();
+	void AppendAscii(FAnsiStringView Text);
+	void AppendQuoted(FAnsiStringView Value);
+	void AppendQuoted(FStringView Value);
+	void AppendQuoted(FUtf8StringView Value);
+	void AppendEscapedAscii(uint8 Char);
+	void AppendCodepoint(uint32 Codepoint);
+
+private:
+	TArray<uint8>& Buffer;
+
+	/** One entry per open object/array; true once the scope holds at least one element. */
+	TArray<bool, TInlineAllocator<16>> ScopeHasElements;
+	bool bAfterKey;
+};
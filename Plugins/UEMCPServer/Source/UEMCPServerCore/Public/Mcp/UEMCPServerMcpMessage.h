@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+class FJsonValue;
+
+/**
+ * A JSON-RPC message decoded once from the request body; the session dispatches on these fields directly.
+ */
+struct FUEMCPServerMcpMessage
+{
+	/** The decoded message object; null when the batch entry was not a JSON object. */
+	TSharedPtr<FJsonObject> Object;
+	TSharedPtr<FJsonValue> Id;
+	TSharedPtr<FJsonObject> Params;
+	FString Method;
+	bool bIsJsonRpc20 = false;
+
+	bool IsValid() const { return Object.IsValid(); }
+	bool IsRequest() const { return !Method.IsEmpty(); }
+};
+
+/**
+ * Every message carried by a single POST body.
+ */
+struct FUEMCPServerMcpPayload
+{
+	TArray<FUEMCPServerMcpMessage> Messages;
+	bool bIsBatch = false;
+
+	bool ContainsMethod(const TCHAR* InMethod) const
+	{
+		return Messages.ContainsByPredicate([InMethod](const FUEMCPServerMcpMessage& Message)
+		{
+			return Message.Method.Equals(InMethod, ESearchCase::CaseSensitive);
+		});
+	}
+};
+
+/**
+ * Replies produced while handling one payload, serialized back to back into a single UTF-8 buffer.
+ */
+struct FUEMCPServerMcpReplies
+{
+	TArray<uint8> Buffer;
+
+	/** Byte offset and length of each reply inside Buffer. */
+	TArray<TPair<int32, int32>> Ranges;
+
+	int32 Num() const { return Ranges.Num(); }
+	bool IsEmpty() const { return Ranges.IsEmpty(); }
+
+	TConstArrayView<uint8> GetReply(int32 Index) const
+	{
+		return TConstArrayView<uint8>(Buffer.GetData() + Ranges[Index].Key, Ranges[Index].Value);
+	}
+
+	/** Marks everything written since StartOffset as one complete reply. */
+	void CommitReply(int32 StartOffset)
+	{
+		Ranges.Emplace(StartOffset, Buffer.Num() - StartOffset);
+	}
+
+	/** Joins every reply into a JSON-RPC batch array. */
+	TArray<uint8> ToJsonArray() const
+	{
+		TArray<uint8> Json;
+		Json.Reserve(Buffer.Num() + Ranges.Num() + 1);
+		Json.Add('[');
+		for (int32 Index = 0; Index < Ranges.Num(); ++Index)
+		{
+			if (Index > 0)
+			{
+				Json.Add(',');
+			}
+			Json.Append(GetReply(Index));
+		}
+		Json.Add(']');
+		return Json;
+	}
+};
@@ -9,6 +9,18 @@ class UEMCPSERVERCORE_API UEMCPServerMcpSchema
 {
 public:
 	static TSharedRef<FJsonObject> BuildToolInputSchema(bool bIncludeWaitFlag);
+	/** Input schema of liveCoding_status: the sinceSequence/limit/tail log cursor plus the severity/file diagnostics filter. */
+	static TSharedRef<FJsonObject> BuildStatusInputSchema();
+	/** Input schema of liveCoding_history: an optional record id plus the same log cursor. */
+	static TSharedRef<FJsonObject> BuildHistoryInputSchema();
 	static TSharedRef<FJsonObject> BuildLiveCodingOutputSchema();
 	static void PopulateToolsList(TArray<TSharedPtr<FJsonValue>>& OutTools);
+
+	/** Serialized JSON array of every tool definition, built on first use and shared until the tool set changes. */
+	static TSharedRef<const TArray<uint8>, ESPMode::ThreadSafe> GetSerializedToolsList();
+
+	/** Rebuilds the cached tools list; OnToolsListChanged fires only when the serialized result actually differs. */
+	static void InvalidateToolsList();
+
+	static FSimpleMulticastDelegate& OnToolsListChanged();
 };
@@ -1,50 +1,109 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "HAL/CriticalSection.h"
+#include "Containers/Ticker.h"
 #include "HttpResultCallback.h"
 #include "HttpRouteHandle.h"
 #include "HttpServerRequest.h"
+#include "Mcp/UEMCPServerAdmissionControl.h"
+#include "Mcp/UEMCPServerHttpUtils.h"
+#include "Mcp/UEMCPServerMcpSettings.h"
+#include "Mcp/UEMCPServerRequestTrace.h"
+#include "Mcp/UEMCPServerResponseCompression.h"
+#include "Mcp/UEMCPServerSerialQueue.h"
+#include "Mcp/UEMCPServerSessionTable.h"
 #include "Misc/Guid.h"
+#include "Templates/Atomic.h"
 
 class IUEMCPServerLiveCodingProvider;
+class FUEMCPServerJsonWriter;
 class FUEMCPServerMcpSession;
 class IHttpRouter;
 
-class IHttpRouter;
+struct FUEMCPServerLogEntry;
+enum class ELiveCodingCompileResult : uint8;
 
 class UEMCPSERVERCORE_API FUEMCPServerMcpServer
 {
 public:
-	FUEMCPServerMcpServer(IUEMCPServerLiveCodingProvider& InLiveCodingManager, uint32 InPort, const FString& InBindAddress);
+	FUEMCPServerMcpServer(IUEMCPServerLiveCodingProvider& InLiveCodingManager, const FUEMCPServerMcpServerSettings& InSettings);
 	~FUEMCPServerMcpServer();
 
 	bool Start();
 	void Stop();
 
 private:
+	/** A POST that passed the game-thread checks and waits in a request queue. */
+	struct FPendingPost
+	{
+		FHttpResultCallback OnComplete;
+		TArray<uint8> Body;
+		FString Endpoint;
+		FString AcceptHeaderValue;
+		TSharedPtr<FUEMCPServerMcpSession> Session;
+		FGuid SessionId;
+		EUEMCPServerSessionSource Source = EUEMCPServerSessionSource::None;
+		bool bHasSessionHeader = false;
+		FUEMCPServerAcceptPreferences Accept;
+		EUEMCPServerContentEncoding Encoding = EUEMCPServerContentEncoding::Identity;
+		FUEMCPServerRequestTrace Trace;
+	};
+
 	bool HandlePostRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+	/**
+	 * Parses, admits and dispatches a queued POST on a worker thread; the response is completed on the game thread.
+	 * OnDone frees the request queue once every message has been answered, so the next request cannot overtake it.
+	 */
+	void ProcessPostRequest(FPendingPost& Post, FUEMCPServerSerialQueue::FOnWorkDone&& OnDone);
+
+	/**
+	 * Serves the session's event stream as a long poll: the HTTP server cannot stream a response, so the request is
+	 * parked until notifications are queued or the heartbeat is due, and then answered with every pending event and
+	 * closed. Each response carries "retry: 0" so an EventSource client reconnects at once, and Last-Event-ID on the
+	 * reconnect resumes after the last event it saw.
+	 */
 	bool HandleGetRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
-	TSharedPtr<FUEMCPServerMcpSession> FindSessionById(const FGuid& ClientId);
-	TSharedPtr<FUEMCPServerMcpSession> CreateSession(const FString& Endpoint, FGuid& OutSessionId);
-	TSharedPtr<FUEMCPServerMcpSession> FindSessionForEndpoint(const FString& Endpoint, FGuid& OutSessionId);
-	TSharedPtr<FUEMCPServerMcpSession> FindDefaultSession(FGuid& OutSessionId);
-	void AssociateEndpointWithSession(const FString& Endpoint, const FGuid& SessionId);
+	bool HandleDeleteRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
 	bool ValidateProtocolVersion(const FString& ProtocolVersionHeader) const;
 	void SetSessionOverrideConfig() const;
 
+	bool TickSessions(float DeltaTime);
+
+	void RegisterServerTools();
+	void UnregisterServerTools();
+	FString WriteMetrics(FUEMCPServerJsonWriter& Writer) const;
+	void HandleCompileFinished(ELiveCodingCompileResult Result);
+	void HandleCompileLog(TConstArrayView<FUEMCPServerLogEntry> Entries);
+	void HandleToolsListChanged();
 
 	IUEMCPServerLiveCodingProvider& LiveCodingManager;
-	uint32 Port;
-	FString BindAddress;
+	FUEMCPServerMcpServerSettings Settings;
 	FString EndpointPath;
 
 	TSharedPtr<IHttpRouter> Router;
 	FHttpRouteHandle PostRouteHandle;
 	FHttpRouteHandle GetRouteHandle;
+	FHttpRouteHandle DeleteRouteHandle;
 	bool bListenersStarted;
 
-	FCriticalSection SessionMutex;
-	TMap<FGuid, TSharedPtr<FUEMCPServerMcpSession>> Sessions;
-	TMap<FString, FGuid> EndpointToSession;
+	FTSTicker::FDelegateHandle SessionTickerHandle;
+	FDelegateHandle CompileFinishedHandle;
+	FDelegateHandle CompileLogHandle;
+	FDelegateHandle ToolsListChangedHandle;
+
+	FUEMCPServerSessionTable SessionTable;
+	TSharedRef<FUEMCPServerAdmissionControl, ESPMode::ThreadSafe> AdmissionControl;
+
+	TSharedRef<FUEMCPServerResponseCompression, ESPMode::ThreadSafe> Compression;
+	TSharedRef<FUEMCPServerRequestTraceBuffer, ESPMode::ThreadSafe> TraceBuffer;
+
+	/** Orders requests that are not bound to a session yet, such as initialize from a new client. */
+	TSharedRef<FUEMCPServerSerialQueue, ESPMode::ThreadSafe> UnboundRequestQueue;
+
+	/**
+	 * Admitted POSTs whose response has not been delivered yet; Stop waits, bounded, for them before tearing the
+	 * session table down. Shared with each request's completion so a late one never touches this server.
+	 */
+	TSharedRef<TAtomic<int32>, ESPMode::ThreadSafe> InFlightPosts;
 };
@@ -2,47 +2,113 @@
 
 #include "CoreMinimal.h"
 #include "HAL/CriticalSection.h"
+#include "HAL/PlatformTime.h"
+#include "HttpResultCallback.h"
+#include "Mcp/UEMCPServerMcpMessage.h"
+#include "Mcp/UEMCPServerSerialQueue.h"
+#include "Misc/Optional.h"
+#include "Templates/Atomic.h"
+#include "Templates/Function.h"
 
 class FJsonObject;
 class FJsonValue;
-class IUEMCPServerLiveCodingProvider;
+class FUEMCPServerJsonWriter;
+
+/** A server-initiated message queued for the GET event stream; the id is unique and increasing within a session. */
+struct FUEMCPServerSseEvent
+{
+	int64 Id = 0;
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Payload;
+};
+
+/** Receives the replies of a payload once every message, including deferred tool calls, has been answered. */
+using FUEMCPServerOnPayloadHandled = TUniqueFunction<void(FUEMCPServerMcpReplies&&)>;
 
 class FUEMCPServerMcpSession : public TSharedFromThis<FUEMCPServerMcpSession>
 {
 public:
-	FUEMCPServerMcpSession(IUEMCPServerLiveCodingProvider& InLiveCodingManager, const FGuid& InClientId, FString InEndpoint);
+	FUEMCPServerMcpSession(const FGuid& InClientId, FString InEndpoint);
 
-	bool HandleMessage(const FString& Message, TArray<FString>& OutgoingMessages);
+	/**
+	 * Dispatches the messages of an already decoded POST payload one after another; a message waits for any deferred
+	 * tool call before it to be answered. OnHandled runs exactly once, on the thread that answers the last message;
+	 * that is the calling thread unless a tool completes asynchronously.
+	 */
+	void HandlePayload(FUEMCPServerMcpPayload&& Payload, FUEMCPServerOnPayloadHandled&& OnHandled);
 	void HandleClosed();
 
+	/**
+	 * Runs Work on a worker thread once every request enqueued before it has called its OnDone, keeping this
+	 * session's requests in order even when their tools answer later on the game thread.
+	 */
+	void EnqueueRequest(TUniqueFunction<void(FUEMCPServerSerialQueue::FOnWorkDone&&)>&& Work) { RequestQueue->EnqueueAsync(MoveTemp(Work)); }
+
+	/** Queues a server-initiated notification for delivery on the session's GET event stream. */
+	void QueueNotification(const FString& Method, TFunctionRef<void(FUEMCPServerJsonWriter&)> WriteParams);
+
+	/**
+	 * Queues a notifications/message at Level, one of the MCP (syslog) level names, unless it is below the level the
+	 * client chose with logging/setLevel. WriteFields adds the fields after "level".
+	 */
+	void QueueLogMessage(FAnsiStringView Level, TFunctionRef<void(FUEMCPServerJsonWriter&)> WriteFields);
+
+	/**
+	 * Parks a GET event stream callback; any previously parked callback is returned so the caller can close it.
+	 * A reconnecting client passes its Last-Event-ID so every retained event after it is sent again.
+	 */
+	FHttpResultCallback AttachEventStream(const FHttpResultCallback& OnComplete, TOptional<int64> LastEventId = {});
+
+	/** Detaches the parked event stream if events are pending, the heartbeat is due or bForce is set. */
+	bool TryDetachEventStream(bool bForce, double HeartbeatSeconds, FHttpResultCallback& OutCallback, TArray<FUEMCPServerSseEvent>& OutEvents);
+
+	/** True while a GET event stream is parked; such sessions count as connected and are never idle-evicted. */
+	bool HasEventStream() const;
+
+	/** Records client activity for idle eviction. */
+	void Touch() { LastActivitySeconds = FPlatformTime::Seconds(); }
+	double GetLastActivitySeconds() const { return LastActivitySeconds; }
+
 	const FGuid& GetClientId() const { return ClientId; }
 	const FString& GetEndpoint() const { return Endpoint; }
 
 private:
-	void ProcessMessage(const FString& Message);
-	void RespondInitialize(const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params);
-	void RespondToolsList(const TSharedPtr<FJsonValue>& IdValue);
-	void RespondToolsCall(const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params);
-	void RespondPing(const TSharedPtr<FJsonValue>& IdValue);
-
-	void HandleCompileTool(const TSharedPtr<FJsonValue>& IdValue);
-	void HandleStatusTool(const TSharedPtr<FJsonValue>& IdValue);
+	struct FPendingPayload;
 
-	void SendToolResult(const TSharedPtr<FJsonValue>& IdValue, const FString& MessageText, const TSharedRef<FJsonObject>& Structured, bool bIsError);
-	void SendResponse(const TSharedPtr<FJsonValue>& IdValue, const TSharedRef<FJsonObject>& ResultObject);
-	void SendError(const TSharedPtr<FJsonValue>& IdValue, int32 Code, const FString& ErrorMessage, const TSharedPtr<FJsonObject>& Data = nullptr);
-	void SendParseError();
-	void SendJson(const TSharedRef<FJsonObject>& Object);
-	void WriteIdField(const TSharedPtr<FJsonValue>& IdValue, const TSharedRef<FJsonObject>& Target) const;
+	/** Dispatches the payload's remaining messages until one is deferred; its completion calls this again. */
+	void DispatchPending(const TSharedRef<FPendingPayload>& Pending);
 
-	TArray<TSharedPtr<FJsonValue>> MakeTextContentArray(const FString& MessageText) const;
-	TSharedRef<FJsonObject> BuildLiveCodingStatus(FString& OutMessage) const;
+	/** Returns false if the message was deferred and its reply will come later. */
+	bool ProcessMessage(const TSharedRef<FPendingPayload>& Pending, const FUEMCPServerMcpMessage& Message);
+	void RespondInitialize(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params);
+	void RespondToolsList(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue);
+	bool RespondToolsCall(const TSharedRef<FPendingPayload>& Pending, const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params);
+	void RespondPing(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue);
+	void RespondSetLevel(FPendingPayload& Pending, const TSharedPtr<FJsonValue>& IdValue, const TSharedPtr<FJsonObject>& Params);
 
 private:
-	IUEMCPServerLiveCodingProvider& LiveCodingManager;
 	FGuid ClientId;
 	FString Endpoint;
-	bool bInitialized;
-	TArray<FString> PendingMessages;
-	FCriticalSection SessionMutex;
+	TAtomic<bool> bInitialized;
+
+	/** Size of the previous reply buffer, used to presize the next one. */
+	TAtomic<int32> LastReplyBytes;
+
+	TAtomic<double> LastActivitySeconds;
+
+	/** Least severe log message level the client wants, as an index into the MCP level names; all by default. */
+	TAtomic<int32> MinLogLevel;
+
+	TSharedRef<FUEMCPServerSerialQueue, ESPMode::ThreadSafe> RequestQueue;
+
+	mutable FCriticalSection StreamMutex;
+	FHttpResultCallback ParkedStream;
+	double ParkedStreamSince;
+	bool bEventStreamOpened;
+
+	/** The most recent events, indexed by Id % capacity, kept after delivery so a reconnecting client can resume. */
+	TArray<FUEMCPServerSseEvent> ReplayRing;
+	int64 NextEventId;
+
+	/** Highest event id already handed to an event stream. */
+	int64 DeliveredEventId;
 };
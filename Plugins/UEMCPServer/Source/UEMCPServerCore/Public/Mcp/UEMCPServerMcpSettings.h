@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Runtime configuration of the MCP server, read by the owning module from the UEMCPServerSettings config section.
+ */
+struct FUEMCPServerMcpServerSettings
+{
+	uint32 Port = 8133;
+	FString BindAddress = TEXT("127.0.0.1");
+
+	/** Longest a liveCoding_compile call with waitForCompletion keeps its HTTP request open. */
+	double CompileWaitTimeoutSeconds = 300.0;
+
+	/** Sessions without requests or a parked event stream for this long are evicted. */
+	double SessionIdleTimeoutSeconds = 1800.0;
+
+	/** Upper bound on live sessions; creating one more evicts the least recently used. */
+	int32 MaxSessions = 64;
+
+	/** Token-bucket limits on JSON-RPC messages received over POST; a rate of zero disables that limit. */
+	double SessionRequestsPerSecond = 20.0;
+	double SessionRequestBurst = 40.0;
+	double GlobalRequestsPerSecond = 100.0;
+	double GlobalRequestBurst = 200.0;
+
+	/** POST requests queued, being processed or waiting on a tool at once; zero disables the cap. */
+	int32 MaxInFlightRequests = 32;
+
+	/** POST response bodies at least this large are compressed when the client allows it; zero or less disables. */
+	int32 CompressionThresholdBytes = 16 * 1024;
+};
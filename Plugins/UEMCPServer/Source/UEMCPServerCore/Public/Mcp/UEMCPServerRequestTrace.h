@@ -0,0 +1,91 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Guid.h"
+#include "Templates/Atomic.h"
+
+class FUEMCPServerJsonWriter;
+
+/** Points in a POST request's life, in the order they are reached. */
+enum class EUEMCPServerRequestPhase : uint8
+{
+	Received,
+	Parsed,
+	Dispatched,
+	Serialized,
+	Completed,
+	Count,
+};
+
+/**
+ * One traced request. Plain data so it can be copied in and out of the ring buffer without locks; nothing is
+ * formatted until the record is read.
+ */
+struct UEMCPSERVERCORE_API FUEMCPServerRequestTrace
+{
+	uint64 RequestId = 0;
+	FGuid SessionId;
+
+	/** FPlatformTime::Cycles64 per phase; zero for phases the request never reached. */
+	uint64 PhaseCycles[static_cast<int32>(EUEMCPServerRequestPhase::Count)] = {};
+
+	int32 RequestBytes = 0;
+	int32 ResponseBytes = 0;
+	int32 StatusCode = 0;
+	int32 MessageCount = 0;
+
+	/** Body size before compression, zero if the response went out uncompressed; ResponseBytes is what was sent. */
+	int32 UncompressedResponseBytes = 0;
+
+	/** FPlatformTime::Cycles64 spent compressing the response, including attempts that did not shrink it. */
+	uint64 CompressCycles = 0;
+
+	/** First method of the payload, or "batch[N]"; truncated, always null-terminated. */
+	ANSICHAR Method[48] = {};
+
+	void SetMethod(const FString& InMethod);
+	void MarkPhase(EUEMCPServerRequestPhase Phase) { PhaseCycles[static_cast<int32>(Phase)] = FPlatformTime::Cycles64(); }
+
+	/** Milliseconds from Received to Phase, or a negative value if the phase was not reached. */
+	double GetElapsedMilliseconds(EUEMCPServerRequestPhase Phase) const;
+
+	/** Short "#id method session" description for log lines; only call it where the line is actually emitted. */
+	FString Describe() const;
+};
+
+/**
+ * Fixed-size ring of the most recent request traces. Writers claim a slot with one atomic increment and publish it
+ * through a per-slot sequence number; readers copy a slot and drop it if a writer touched it meanwhile.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerRequestTraceBuffer
+{
+public:
+	FUEMCPServerRequestTraceBuffer();
+
+	/** Allocates the id that ties a request's log lines to its trace record. */
+	uint64 NextRequestId() { return NextId.IncrementExchange() + 1; }
+
+	/** Stores a finished request and mirrors it to the UE Insights trace channel. */
+	void Record(const FUEMCPServerRequestTrace& Trace);
+
+	/** Up to MaxRecords of the newest records, newest first, skipping requests shorter than MinDurationMs. */
+	TArray<FUEMCPServerRequestTrace> Snapshot(int32 MaxRecords, double MinDurationMs = 0.0) const;
+
+	/** Writes records as the server_trace tool's structured content; returns the summary text. */
+	static FString WriteRecords(FUEMCPServerJsonWriter& Writer, TConstArrayView<FUEMCPServerRequestTrace> Records);
+
+	static constexpr int32 Capacity = 512;
+
+private:
+	struct FSlot
+	{
+		/** 2 * write index + 1 while being written, 2 * write index + 2 once published, 0 if never written. */
+		TAtomic<uint64> Sequence;
+		FUEMCPServerRequestTrace Trace;
+	};
+
+	TAtomic<uint64> NextId;
+	TAtomic<uint64> WriteCursor;
+	FSlot Slots[Capacity];
+};
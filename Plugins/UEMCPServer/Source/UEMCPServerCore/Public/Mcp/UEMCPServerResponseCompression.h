@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+
+struct FHttpServerResponse;
+struct FUEMCPServerMcpServerSettings;
+
+enum class EUEMCPServerContentEncoding : uint8
+{
+	Identity,
+	Gzip,
+	Deflate,
+};
+
+struct FUEMCPServerCompressionMetrics
+{
+	uint64 Compressed = 0;
+	uint64 SkippedBelowThreshold = 0;
+	uint64 SkippedNotSmaller = 0;
+	uint64 UncompressedBytes = 0;
+	uint64 CompressedBytes = 0;
+	double CpuMilliseconds = 0.0;
+};
+
+/**
+ * Compresses large response bodies with the engine's zlib codecs according to the client's Accept-Encoding.
+ * Shared by reference with pending completions, like the admission control.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerResponseCompression
+{
+public:
+	explicit FUEMCPServerResponseCompression(const FUEMCPServerMcpServerSettings& Settings);
+
+	/** Picks gzip or deflate from an Accept-Encoding header, honoring q=0; identity when neither is acceptable. */
+	static EUEMCPServerContentEncoding NegotiateEncoding(FStringView AcceptEncoding);
+
+	/**
+	 * Replaces the body with its compressed form and sets Content-Encoding, if it is large enough and shrinks.
+	 * Returns the cycles spent compressing, zero if it was not attempted.
+	 */
+	uint64 CompressResponse(FHttpServerResponse& Response, EUEMCPServerContentEncoding Encoding);
+
+	FUEMCPServerCompressionMetrics GetMetrics() const;
+	int32 GetThresholdBytes() const { return ThresholdBytes; }
+
+private:
+	int32 ThresholdBytes;
+
+	TAtomic<uint64> Compressed;
+	TAtomic<uint64> SkippedBelowThreshold;
+	TAtomic<uint64> SkippedNotSmaller;
+	TAtomic<uint64> UncompressedBytes;
+	TAtomic<uint64> CompressedBytes;
+	TAtomic<uint64> CompressCycles;
+};
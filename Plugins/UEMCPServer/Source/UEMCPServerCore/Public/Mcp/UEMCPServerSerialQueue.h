@@ -0,0 +1,28 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+
+/**
+ * Runs queued work on task-graph worker threads strictly one item at a time, in enqueue order. Independent queues
+ * drain in parallel; an idle queue holds no thread.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerSerialQueue : public TSharedFromThis<FUEMCPServerSerialQueue, ESPMode::ThreadSafe>
+{
+public:
+	/** Releases the queue for its next item; called exactly once, from any thread. */
+	using FOnWorkDone = TUniqueFunction<void()>;
+
+	void Enqueue(TUniqueFunction<void()>&& Work);
+
+	/** Queues work that may finish on another thread; the next item only starts once it has called OnDone. */
+	void EnqueueAsync(TUniqueFunction<void(FOnWorkDone&&)>&& Work);
+
+private:
+	void Drain();
+
+	FCriticalSection Mutex;
+	TArray<TUniqueFunction<void(FOnWorkDone&&)>> Pending;
+	bool bDraining = false;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Guid.h"
+
+class FUEMCPServerMcpSession;
+
+/** How ResolveSession found (or made) the session for a request. */
+enum class EUEMCPServerSessionSource : uint8
+{
+	None,
+	/** Named by the Mcp-Session-Id header or query parameter. */
+	Header,
+	/** Last session used from the same peer endpoint. */
+	Endpoint,
+	/** The only session that exists. */
+	Default,
+	Created,
+};
+
+struct FUEMCPServerSessionLookup
+{
+	TSharedPtr<FUEMCPServerMcpSession> Session;
+	FGuid SessionId;
+	EUEMCPServerSessionSource Source = EUEMCPServerSessionSource::None;
+
+	/** Sessions pushed out by the session cap to make room for a new one; the caller closes them. */
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> Evicted;
+
+	/** No session was created because every session at the cap has a live event stream. */
+	bool bSessionLimitReached = false;
+};
+
+struct FUEMCPServerSessionMetrics
+{
+	int32 LiveSessions = 0;
+	uint64 CreatedSessions = 0;
+	uint64 IdleEvictions = 0;
+	uint64 CapacityEvictions = 0;
+	uint64 RejectedAtCapacity = 0;
+	uint64 ClientTerminations = 0;
+};
+
+/**
+ * Sessions keyed by id plus the endpoint affinity map. Lookups share a read lock; the write lock is only taken
+ * when a session is created or removed, or an endpoint moves to a different session.
+ *
+ * Idle sessions are expired through a hashed timer wheel: each session sits in the slot of its projected expiry and
+ * is re-slotted lazily when the sweep finds it was active in the meantime, so request handling never touches the wheel.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerSessionTable
+{
+public:
+	FUEMCPServerSessionTable(double InIdleTimeoutSeconds, int32 InMaxSessions);
+
+	/**
+	 * Resolves the session for a request in one pass. With a requested id only that session is considered; otherwise
+	 * the endpoint's session, then the sole existing session, then a new one when bAllowCreate is set.
+	 */
+	FUEMCPServerSessionLookup ResolveSession(const FGuid* RequestedId, const FString& Endpoint, bool bAllowCreate);
+
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> GetSessions() const;
+
+	/** Removes a session at the client's request (DELETE /mcp). */
+	TSharedPtr<FUEMCPServerMcpSession> RemoveSession(const FGuid& SessionId);
+
+	/** Advances the timer wheel to Now and returns the sessions that have been idle past the timeout. */
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> EvictIdleSessions(double Now);
+
+	/** Removes every session and returns them so the caller can close them outside the lock. */
+	TArray<TSharedPtr<FUEMCPServerMcpSession>> RemoveAll();
+
+	FUEMCPServerSessionMetrics GetMetrics() const;
+
+private:
+	/** Returns true when the endpoint already points at SessionId. Caller holds at least the read lock. */
+	bool IsEndpointMapped(const FString& Endpoint, const FGuid& SessionId) const;
+
+	/** The following require the write lock. */
+	void MapEndpoint(const FString& Endpoint, const FGuid& SessionId);
+	TSharedPtr<FUEMCPServerMcpSession> RemoveSessionLocked(const FGuid& SessionId);
+	TSharedPtr<FUEMCPServerMcpSession> EvictLeastRecentlyUsedLocked();
+	void ScheduleExpiry(const FGuid& SessionId, double ExpirySeconds);
+
+	mutable FRWLock Lock;
+	TMap<FGuid, TSharedPtr<FUEMCPServerMcpSession>> Sessions;
+	TMap<FString, FGuid> EndpointToSession;
+
+	/** Endpoints mapped to each session, oldest first, so stale peer ports can be dropped. */
+	TMap<FGuid, TArray<FString>> SessionEndpoints;
+
+	double IdleTimeoutSeconds;
+	int32 MaxSessions;
+
+	TArray<TArray<FGuid>> TimerWheel;
+	double WheelGranularitySeconds;
+	int64 WheelCursor;
+
+	FUEMCPServerSessionMetrics Metrics;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonObject.h"
+#include "Misc/Guid.h"
+#include "Templates/Function.h"
+
+class FUEMCPServerJsonWriter;
+
+/** Where a tool handler is allowed to run. */
+enum class EUEMCPServerToolAffinity : uint8
+{
+	/** Invoked on whichever thread is processing the request. */
+	AnyThread,
+	/** Always invoked on the game thread. */
+	GameThread,
+};
+
+/** Arguments of a single tools/call request. */
+struct FUEMCPServerToolCall
+{
+	FGuid SessionId;
+
+	/** The call's "arguments" object; never null, empty when the client sent none. */
+	TSharedRef<FJsonObject> Arguments;
+};
+
+/** Outcome of a tool call, serialized into the tools/call result by the session. */
+struct UEMCPSERVERCORE_API FUEMCPServerToolResult
+{
+	/** Text mirrored into the MCP content array. */
+	FString Message;
+
+	/** Serialized JSON object for structuredContent; omitted when empty. */
+	TArray<uint8> StructuredContent;
+
+	bool bIsError = false;
+
+	/** Builds a result whose structured content is written by WriteStructured, which returns the summary text. */
+	static FUEMCPServerToolResult Make(TFunctionRef<FString(FUEMCPServerJsonWriter&)> WriteStructured, bool bIsError = false);
+};
+
+/** Completes a tool call; may be invoked from any thread, exactly once. */
+using FUEMCPServerToolCompletion = TFunction<void(FUEMCPServerToolResult&&)>;
+using FUEMCPServerToolHandler = TFunction<void(const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete)>;
+
+struct FUEMCPServerToolDefinition
+{
+	FString Name;
+	FString Title;
+	FString Description;
+	TSharedPtr<FJsonObject> InputSchema;
+	TSharedPtr<FJsonObject> OutputSchema;
+	bool bReadOnlyHint = false;
+	bool bDestructiveHint = false;
+	EUEMCPServerToolAffinity Affinity = EUEMCPServerToolAffinity::AnyThread;
+	FUEMCPServerToolHandler Handler;
+};
+
+using FUEMCPServerToolRef = TSharedRef<const FUEMCPServerToolDefinition, ESPMode::ThreadSafe>;
+using FUEMCPServerToolPtr = TSharedPtr<const FUEMCPServerToolDefinition, ESPMode::ThreadSafe>;
+
+/**
+ * Process-wide table of MCP tools. Modules register tools here; tools/list and tools/call are served from it.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerToolRegistry
+{
+public:
+	static FUEMCPServerToolRegistry& Get();
+
+	/** Adds a tool; returns false if the name is empty, the handler is unbound or the name is already taken. */
+	bool RegisterTool(FUEMCPServerToolDefinition&& Definition);
+	bool UnregisterTool(const FString& Name);
+
+	/** Hashed lookup; the returned reference keeps the handler alive while a call is in flight. */
+	FUEMCPServerToolPtr FindTool(const FString& Name) const;
+
+	/** Every registered tool, sorted by name so the serialized tools list is stable. */
+	TArray<FUEMCPServerToolRef> GetTools() const;
+
+	/** Runs the tool's handler on a thread matching its affinity. */
+	static void InvokeTool(const FUEMCPServerToolRef& Tool, const FUEMCPServerToolCall& Call, FUEMCPServerToolCompletion&& OnComplete);
+
+private:
+	mutable FRWLock ToolsLock;
+	TMap<FString, FUEMCPServerToolRef> Tools;
+};
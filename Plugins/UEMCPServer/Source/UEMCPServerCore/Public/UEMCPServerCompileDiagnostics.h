@@ -0,0 +1,89 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class EUEMCPServerDiagnosticSeverity : uint8
+{
+	Error,
+	Warning,
+};
+
+/** One compiler or build tool error or warning recognised in the compile log. */
+struct FUEMCPServerCompileDiagnostic
+{
+	/** Sequence of the log line it was parsed from. */
+	int64 Sequence = 0;
+	EUEMCPServerDiagnosticSeverity Severity = EUEMCPServerDiagnosticSeverity::Error;
+
+	/** Source or object file with forward slashes; empty for tool-level diagnostics such as "LINK : fatal error". */
+	FString File;
+
+	/** 1-based; 0 when the diagnostic carries no location. */
+	int32 Line = 0;
+	int32 Column = 0;
+
+	/** "C2065", "LNK2019", "-Wunused-variable" and so on; empty when the tool prints none. */
+	FString Code;
+	FString Message;
+};
+
+/** Which diagnostics a caller wants; an unset field matches everything. */
+struct FUEMCPServerDiagnosticFilter
+{
+	TOptional<EUEMCPServerDiagnosticSeverity> Severity;
+
+	/** Case-insensitive substring of the file path; either slash direction matches. */
+	FString File;
+
+	bool Matches(const FUEMCPServerCompileDiagnostic& Diagnostic) const;
+};
+
+/**
+ * Errors and warnings parsed from a compile log one line at a time as it is captured, so nothing is re-scanned
+ * when a client asks for them. Recognises MSVC and UHT ("File(Line[,Col]): error C1234: ..."), clang
+ * ("File:Line[:Col]: error: ... [-Wflag]"), linker ("LINK : fatal error LNK1234: ...") and UBT ("ERROR: ...") lines.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerCompileDiagnostics
+{
+public:
+	/** Parses one log line; returns true if it was a diagnostic and was added. */
+	bool AddLine(int64 Sequence, FStringView Message);
+
+	void Reset();
+
+	const TArray<FUEMCPServerCompileDiagnostic>& GetDiagnostics() const { return Diagnostics; }
+	int32 NumErrors() const { return ErrorCount; }
+	int32 NumWarnings() const { return WarningCount; }
+
+	/** Parses a single line without recording it. */
+	static bool ParseLine(FStringView Message, FUEMCPServerCompileDiagnostic& OutDiagnostic);
+
+private:
+	TArray<FUEMCPServerCompileDiagnostic> Diagnostics;
+	int32 ErrorCount = 0;
+	int32 WarningCount = 0;
+};
+
+namespace UEMCPServer
+{
+	inline const TCHAR* DiagnosticSeverityToString(EUEMCPServerDiagnosticSeverity Severity)
+	{
+		return Severity == EUEMCPServerDiagnosticSeverity::Warning ? TEXT("warning") : TEXT("error");
+	}
+
+	/** Accepts "error" or "warning" in any case. */
+	inline bool DiagnosticSeverityFromString(FStringView Text, EUEMCPServerDiagnosticSeverity& OutSeverity)
+	{
+		if (Text.Equals(TEXT("error"), ESearchCase::IgnoreCase))
+		{
+			OutSeverity = EUEMCPServerDiagnosticSeverity::Error;
+			return true;
+		}
+		if (Text.Equals(TEXT("warning"), ESearchCase::IgnoreCase))
+		{
+			OutSeverity = EUEMCPServerDiagnosticSeverity::Warning;
+			return true;
+		}
+		return false;
+	}
+}
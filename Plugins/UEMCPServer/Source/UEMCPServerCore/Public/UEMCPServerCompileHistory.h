@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UEMCPServerLiveCodingTypes.h"
+
+#include "HAL/CriticalSection.h"
+
+class FUEMCPServerLiveCodingLogBuffer;
+struct FUEMCPServerHistoryMapping;
+
+/** What the history keeps in memory about an archived compile; its log stays in the file until asked for. */
+struct FUEMCPServerCompileSummary
+{
+	int64 Id = 0;
+	FDateTime StartTime = FDateTime(0);
+	FDateTime FinishTime = FDateTime(0);
+	ELiveCodingCompileResult Result = ELiveCodingCompileResult::NotStarted;
+	FString TriggerSource;
+	int32 NumLines = 0;
+	/** Compiler and build tool diagnostics, counted the same way as the live status. */
+	int32 NumErrors = 0;
+	int32 NumWarnings = 0;
+};
+
+/**
+ * One archived compile read in place from the memory-mapped history file. Every string is a view into the mapping,
+ * which stays mapped for as long as the record is referenced; hold it only for the duration of one call.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerCompileRecord
+{
+public:
+	const FUEMCPServerCompileSummary& GetSummary() const { return Summary; }
+	FUtf8StringView GetErrorMessage() const { return ErrorMessage; }
+
+	int32 NumLines() const { return Summary.NumLines; }
+	int64 GetSequence(int32 Index) const;
+	FDateTime GetTimestamp(int32 Index) const;
+	ELogVerbosity::Type GetVerbosity(int32 Index) const;
+	FUtf8StringView GetCategory(int32 Index) const;
+	FUtf8StringView GetMessage(int32 Index) const;
+
+	/** Selects lines exactly like FUEMCPServerLiveCodingLogBuffer::SelectPage. */
+	FUEMCPServerLogPage SelectPage(const FUEMCPServerLogQuery& Query) const;
+
+private:
+	friend class FUEMCPServerCompileHistory;
+
+	TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> Mapping;
+	const uint8* Lines = nullptr;
+	const UTF8CHAR* Strings = nullptr;
+	FUtf8StringView ErrorMessage;
+	FUEMCPServerCompileSummary Summary;
+};
+
+using FUEMCPServerCompileRecordPtr = TSharedPtr<const FUEMCPServerCompileRecord, ESPMode::ThreadSafe>;
+
+/**
+ * Rolling archive of the last Capacity compiles in an append-only binary file. Open drops the records beyond
+ * Capacity, and any torn tail, by compacting the file; while the editor runs it is compacted again whenever the
+ * rolled-out records outweigh the live ones. Reads map the file and hand out records that point straight into it.
+ * Thread-safe.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerCompileHistory
+{
+public:
+	FUEMCPServerCompileHistory(FString InFilename, int32 InCapacity);
+	~FUEMCPServerCompileHistory();
+
+	/** Builds the offset index from the file, compacting it first if needed. */
+	void Open();
+
+	/** Appends a finished compile; Id and NumLines are filled in, the counts are the caller's. Returns the new id, or 0. */
+	int64 Append(FUEMCPServerCompileSummary Summary, FStringView ErrorMessage, const FUEMCPServerLiveCodingLogBuffer& Log);
+
+	/** Up to MaxCount summaries, newest first. */
+	TArray<FUEMCPServerCompileSummary> GetSummaries(int32 MaxCount) const;
+
+	/** The archived compile with this id, or null if it is unknown or has rolled out of the history. */
+	FUEMCPServerCompileRecordPtr FindRecord(int64 Id) const;
+
+	int32 GetCapacity() const { return Capacity; }
+	const FString& GetFilename() const { return Filename; }
+
+private:
+	struct FIndexEntry
+	{
+		FUEMCPServerCompileSummary Summary;
+		int64 Offset = 0;
+		int64 Bytes = 0;
+	};
+
+	/** Rewrites the file without rolled-out records once they waste more than the live ones; callers hold Mutex. */
+	void CompactIfWastefulLocked();
+
+	/** The file header followed by the records of InOutEntries read from Data; their offsets are updated to match. */
+	static TArray<uint8> BuildCompacted(const uint8* Data, TArray<FIndexEntry>& InOutEntries);
+
+	/** Swaps Contents in as the whole history file; callers hold Mutex and have dropped their mapping. */
+	bool ReplaceFileLocked(const TArray<uint8>& Contents) const;
+
+	/** Maps the whole file as it is now; callers hold Mutex. */
+	TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> GetMapping() const;
+
+	FString Filename;
+	int32 Capacity;
+
+	mutable FCriticalSection Mutex;
+
+	/** Offsets of the newest Capacity records, oldest first; ids increase along it. */
+	TArray<FIndexEntry> Index;
+	int64 FileSize = 0;
+	int64 NextId = 1;
+
+	/** Mapping of the current file contents; dropped on append, records already handed out keep theirs. */
+	mutable TSharedPtr<const FUEMCPServerHistoryMapping, ESPMode::ThreadSafe> Mapping;
+};
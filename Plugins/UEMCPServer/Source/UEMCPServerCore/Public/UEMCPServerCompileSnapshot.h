@@ -0,0 +1,23 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UEMCPServerCompileDiagnostics.h"
+#include "UEMCPServerLiveCodingLogBuffer.h"
+#include "UEMCPServerLiveCodingTypes.h"
+
+/**
+ * The state of the latest compile, published whole by the provider and never modified afterwards, so any thread
+ * may read it without locks. A new compile publishes a new snapshot; snapshots share a log until it is replaced.
+ */
+struct FUEMCPServerCompileSnapshot
+{
+	TSharedRef<const FUEMCPServerLiveCodingLogBuffer, ESPMode::ThreadSafe> Log = MakeShared<FUEMCPServerLiveCodingLogBuffer, ESPMode::ThreadSafe>();
+	TSharedRef<const FUEMCPServerCompileDiagnostics, ESPMode::ThreadSafe> Diagnostics = MakeShared<FUEMCPServerCompileDiagnostics, ESPMode::ThreadSafe>();
+	FDateTime Timestamp = FDateTime(0);
+	ELiveCodingCompileResult Result = ELiveCodingCompileResult::NotStarted;
+	bool bHasResult = false;
+	bool bCompileInProgress = false;
+	FString ErrorMessage;
+};
+
+using FUEMCPServerCompileSnapshotRef = TSharedRef<const FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe>;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UEMCPServerLiveCodingTypes.h"
+
+#include "Logging/LogVerbosity.h"
+
+/**
+ * Columnar store of captured log lines. Categories are kept as FNames and verbosity as the enum; message text is
+ * appended as UTF-8 into large chunks, so a compile's log costs a few allocations in total and is freed at once.
+ * Move-only: message views point into chunks the buffer owns.
+ */
+class UEMCPSERVERCORE_API FUEMCPServerLiveCodingLogBuffer
+{
+public:
+	FUEMCPServerLiveCodingLogBuffer() = default;
+	FUEMCPServerLiveCodingLogBuffer(FUEMCPServerLiveCodingLogBuffer&&) = default;
+	FUEMCPServerLiveCodingLogBuffer& operator=(FUEMCPServerLiveCodingLogBuffer&&) = default;
+	FUEMCPServerLiveCodingLogBuffer(const FUEMCPServerLiveCodingLogBuffer&) = delete;
+	FUEMCPServerLiveCodingLogBuffer& operator=(const FUEMCPServerLiveCodingLogBuffer&) = delete;
+
+	/** Appends a line; sequences must be added in increasing order. */
+	void Add(int64 Sequence, FName Category, ELogVerbosity::Type Verbosity, const FDateTime& Timestamp, FStringView Message);
+
+	/** Drops every line and releases the arena in one step. */
+	void Reset();
+
+	int32 Num() const { return Sequences.Num(); }
+	bool IsEmpty() const { return Sequences.IsEmpty(); }
+
+	int64 GetSequence(int32 Index) const { return Sequences[Index]; }
+	FName GetCategory(int32 Index) const { return Categories[Index]; }
+	ELogVerbosity::Type GetVerbosity(int32 Index) const { return static_cast<ELogVerbosity::Type>(Verbosities[Index]); }
+	FDateTime GetTimestamp(int32 Index) const { return FDateTime(TimestampTicks[Index]); }
+	FUtf8StringView GetMessage(int32 Index) const { return Messages[Index]; }
+
+	/** Index of the first line with a sequence greater than Sequence, or Num() if there is none. */
+	int32 FindFirstAfter(int64 Sequence) const;
+
+	/** Selects the lines a query asks for; lines are stored in sequence order, so this is a binary search. */
+	FUEMCPServerLogPage SelectPage(const FUEMCPServerLogQuery& Query) const;
+
+	/** Copies one line out as a standalone entry. */
+	FUEMCPServerLogEntry MakeEntry(int32 Index) const;
+
+	/** Bytes held by the columns and the arena. */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	/** Copies Text into the arena and returns a view of the copy. */
+	FUtf8StringView AppendToArena(FUtf8StringView Text);
+
+	struct FChunk
+	{
+		TArray<UTF8CHAR> Data;
+	};
+
+	TArray<int64> Sequences;
+	TArray<int64> TimestampTicks;
+	TArray<FName> Categories;
+	TArray<uint8> Verbosities;
+	TArray<FUtf8StringView> Messages;
+	TArray<FChunk> Chunks;
+};
@@ -3,20 +3,70 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Logging/LogVerbosity.h"
 #include "Misc/DateTime.h"
 
 struct FUEMCPServerLogEntry
 {
+	/** Position in the capture's log stream; keeps increasing across compiles, so a cursor never goes stale. */
+	int64 Sequence = 0;
 	FString Message;
-	FString Category;
-	FString Verbosity;
+	FName Category;
+	ELogVerbosity::Type Verbosity = ELogVerbosity::Log;
 	FDateTime Timestamp;
 };
 
+/** Which slice of a compile log to read. */
+struct FUEMCPServerLogQuery
+{
+	/** Only entries with a greater Sequence are returned. */
+	int64 SinceSequence = 0;
+
+	/** Maximum number of entries to return; negative for no limit. */
+	int32 Limit = INDEX_NONE;
+
+	/** When the limit cuts the slice, keep its newest entries rather than its oldest. */
+	bool bTail = false;
+};
+
+/** The slice of a compile log selected by a query, as a range of line indices, and the cursor to resume from. */
+struct FUEMCPServerLogPage
+{
+	int32 FirstIndex = 0;
+	int32 NumEntries = 0;
+
+	/** Pass back as SinceSequence to continue after this page. */
+	int64 NextSequence = 0;
+
+	/** Entries after NextSequence that the limit left out. */
+	int32 RemainingEntries = 0;
+
+	/** Entries in the whole compile log, returned or not. */
+	int32 TotalEntries = 0;
+};
+
 #include "ILiveCodingModule.h"
 
 namespace UEMCPServer
 {
+	/**
+	 * Applies a query's limit and tail to a log of NumLines lines stored in sequence order. FirstUnseen is the index
+	 * of the first line after Query.SinceSequence; SequenceAt returns a line's sequence.
+	 */
+	template <typename SequenceAtType>
+	FUEMCPServerLogPage SelectLogPage(const FUEMCPServerLogQuery& Query, int32 NumLines, int32 FirstUnseen, SequenceAtType&& SequenceAt)
+	{
+		const int32 NumUnseen = NumLines - FirstUnseen;
+
+		FUEMCPServerLogPage Page;
+		Page.NumEntries = Query.Limit < 0 ? NumUnseen : FMath::Min(NumUnseen, Query.Limit);
+		Page.FirstIndex = Query.bTail ? NumLines - Page.NumEntries : FirstUnseen;
+		Page.NextSequence = Page.NumEntries > 0 ? SequenceAt(Page.FirstIndex + Page.NumEntries - 1) : Query.SinceSequence;
+		Page.RemainingEntries = NumLines - (Page.FirstIndex + Page.NumEntries);
+		Page.TotalEntries = NumLines;
+		return Page;
+	}
+
 	inline FString CompileResultToString(ELiveCodingCompileResult CompileResult)
 	{
 		switch (CompileResult)
@@ -26,7 +26,8 @@ public class UEMCPServerCore : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
-                "LiveCoding"
+                "LiveCoding",
+                "TraceLog"
 			}
 		);
 	}
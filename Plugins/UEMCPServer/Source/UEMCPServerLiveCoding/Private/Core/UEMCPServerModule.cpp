@@ -2,6 +2,7 @@
 
 #include "Mcp/UEMCPServerMcpServer.h"
 #include "UEMCPServerEditorModeCommands.h"
+#include "LiveCoding/UEMCPServerLiveCodingLogCapture.h"
 #include "LiveCoding/UEMCPServerLiveCodingManager.h"
 #include "UEMCPServerLiveCodingTypes.h"
 #include "UEMCPServerLog.h"
@@ -20,12 +21,26 @@ namespace UEMCPServer
     static constexpr const TCHAR* LegacyConfigPortKey = TEXT("LiveCodingWebSocketPort");
     static constexpr const TCHAR* ConfigBindKey = TEXT("LiveCodingHttpBindAddress");
     static constexpr const TCHAR* LegacyConfigBindKey = TEXT("LiveCodingWebSocketBindAddress");
+    static constexpr const TCHAR* ConfigCompileWaitTimeoutKey = TEXT("CompileWaitTimeoutSeconds");
+    static constexpr const TCHAR* ConfigSessionIdleTimeoutKey = TEXT("SessionIdleTimeoutSeconds");
+    static constexpr const TCHAR* ConfigMaxSessionsKey = TEXT("MaxSessions");
+    static constexpr const TCHAR* ConfigSessionRateKey = TEXT("SessionRequestsPerSecond");
+    static constexpr const TCHAR* ConfigSessionBurstKey = TEXT("SessionRequestBurst");
+    static constexpr const TCHAR* ConfigGlobalRateKey = TEXT("GlobalRequestsPerSecond");
+    static constexpr const TCHAR* ConfigGlobalBurstKey = TEXT("GlobalRequestBurst");
+    static constexpr const TCHAR* ConfigMaxInFlightKey = TEXT("MaxInFlightRequests");
+    static constexpr const TCHAR* ConfigCompressionThresholdKey = TEXT("CompressionThresholdBytes");
+    static constexpr const TCHAR* ConfigLogCaptureCategoriesKey = TEXT("LogCaptureCategories");
+    static constexpr const TCHAR* ConfigCompileHistoryCapacityKey = TEXT("CompileHistoryCapacity");
+    static constexpr int32 DefaultCompileHistoryCapacity = 50;
 }
 
 void FUEMCPServerModule::StartupModule()
 {
-    McpServerPort = UEMCPServer::DefaultPort;
-    McpBindAddress = TEXT("127.0.0.1");
+    McpSettings = FUEMCPServerMcpServerSettings();
+    McpSettings.Port = UEMCPServer::DefaultPort;
+    FUEMCPServerLogCaptureSettings CaptureSettings = FUEMCPServerLogCaptureSettings::MakeDefault();
+    int32 CompileHistoryCapacity = UEMCPServer::DefaultCompileHistoryCapacity;
 
     if (GConfig)
     {
@@ -33,12 +48,12 @@ void FUEMCPServerModule::StartupModule()
         if (GConfig->GetInt(UEMCPServer::ConfigSection, UEMCPServer::ConfigPortKey, ConfiguredPort, GEditorPerProjectIni)
             && ConfiguredPort > 0 && ConfiguredPort <= TNumericLimits<uint16>::Max())
         {
-            McpServerPort = static_cast<uint32>(ConfiguredPort);
+            McpSettings.Port = static_cast<uint32>(ConfiguredPort);
         }
         else if (GConfig->GetInt(UEMCPServer::ConfigSection, UEMCPServer::LegacyConfigPortKey, ConfiguredPort, GEditorPerProjectIni)
             && ConfiguredPort > 0 && ConfiguredPort <= TNumericLimits<uint16>::Max())
         {
-            McpServerPort = static_cast<uint32>(ConfiguredPort);
+            McpSettings.Port = static_cast<uint32>(ConfiguredPort);
             UE_LOG(LogUEMCPServer, Verbose, TEXT("Using legacy configuration key LiveCodingWebSocketPort (%d) for MCP server port."), ConfiguredPort);
         }
 
@@ -46,30 +61,105 @@ void FUEMCPServerModule::StartupModule()
         if (GConfig->GetString(UEMCPServer::ConfigSection, UEMCPServer::ConfigBindKey, ConfiguredBind, GEditorPerProjectIni)
             && !ConfiguredBind.IsEmpty())
         {
-            McpBindAddress = ConfiguredBind;
+            McpSettings.BindAddress = ConfiguredBind;
         }
         else if (GConfig->GetString(UEMCPServer::ConfigSection, UEMCPServer::LegacyConfigBindKey, ConfiguredBind, GEditorPerProjectIni)
             && !ConfiguredBind.IsEmpty())
         {
-            McpBindAddress = ConfiguredBind;
+            McpSettings.BindAddress = ConfiguredBind;
             UE_LOG(LogUEMCPServer, Verbose, TEXT("Using legacy configuration key LiveCodingWebSocketBindAddress (%s) for MCP server bind address."), *ConfiguredBind);
         }
+
+        double ConfiguredWaitTimeout = 0.0;
+        if (GConfig->GetDouble(UEMCPServer::ConfigSection, UEMCPServer::ConfigCompileWaitTimeoutKey, ConfiguredWaitTimeout, GEditorPerProjectIni)
+            && ConfiguredWaitTimeout > 0.0)
+        {
+            McpSettings.CompileWaitTimeoutSeconds = ConfiguredWaitTimeout;
+        }
+
+        double ConfiguredIdleTimeout = 0.0;
+        if (GConfig->GetDouble(UEMCPServer::ConfigSection, UEMCPServer::ConfigSessionIdleTimeoutKey, ConfiguredIdleTimeout, GEditorPerProjectIni)
+            && ConfiguredIdleTimeout > 0.0)
+        {
+            McpSettings.SessionIdleTimeoutSeconds = ConfiguredIdleTimeout;
+        }
+
+        int32 ConfiguredMaxSessions = 0;
+        if (GConfig->GetInt(UEMCPServer::ConfigSection, UEMCPServer::ConfigMaxSessionsKey, ConfiguredMaxSessions, GEditorPerProjectIni)
+            && ConfiguredMaxSessions > 0)
+        {
+            McpSettings.MaxSessions = ConfiguredMaxSessions;
+        }
+
+        // Zero is meaningful for the admission limits (it disables them), so only negative values are ignored.
+        double ConfiguredLimit = 0.0;
+        if (GConfig->GetDouble(UEMCPServer::ConfigSection, UEMCPServer::ConfigSessionRateKey, ConfiguredLimit, GEditorPerProjectIni) && ConfiguredLimit >= 0.0)
+        {
+            McpSettings.SessionRequestsPerSecond = ConfiguredLimit;
+        }
+        if (GConfig->GetDouble(UEMCPServer::ConfigSection, UEMCPServer::ConfigSessionBurstKey, ConfiguredLimit, GEditorPerProjectIni) && ConfiguredLimit >= 0.0)
+        {
+            McpSettings.SessionRequestBurst = ConfiguredLimit;
+        }
+        if (GConfig->GetDouble(UEMCPServer::ConfigSection, UEMCPServer::ConfigGlobalRateKey, ConfiguredLimit, GEditorPerProjectIni) && ConfiguredLimit >= 0.0)
+        {
+            McpSettings.GlobalRequestsPerSecond = ConfiguredLimit;
+        }
+        if (GConfig->GetDouble(UEMCPServer::ConfigSection, UEMCPServer::ConfigGlobalBurstKey, ConfiguredLimit, GEditorPerProjectIni) && ConfiguredLimit >= 0.0)
+        {
+            McpSettings.GlobalRequestBurst = ConfiguredLimit;
+        }
+
+        int32 ConfiguredMaxInFlight = 0;
+        if (GConfig->GetInt(UEMCPServer::ConfigSection, UEMCPServer::ConfigMaxInFlightKey, ConfiguredMaxInFlight, GEditorPerProjectIni) && ConfiguredMaxInFlight >= 0)
+        {
+            McpSettings.MaxInFlightRequests = ConfiguredMaxInFlight;
+        }
+
+        int32 ConfiguredCompressionThreshold = 0;
+        if (GConfig->GetInt(UEMCPServer::ConfigSection, UEMCPServer::ConfigCompressionThresholdKey, ConfiguredCompressionThreshold, GEditorPerProjectIni))
+        {
+            McpSettings.CompressionThresholdBytes = ConfiguredCompressionThreshold;
+        }
+
+        // Entries are "Category" or "*Text*" for every category containing Text, optionally with ":Verbosity"; any
+        // configured list replaces the default "*LiveCoding*".
+        TArray<FString> ConfiguredCategories;
+        if (GConfig->GetArray(UEMCPServer::ConfigSection, UEMCPServer::ConfigLogCaptureCategoriesKey, ConfiguredCategories, GEditorPerProjectIni) > 0)
+        {
+            CaptureSettings.Categories.Reset();
+            for (const FString& Entry : ConfiguredCategories)
+            {
+                if (!CaptureSettings.AddCategory(Entry))
+                {
+                    UE_LOG(LogUEMCPServer, Warning, TEXT("Ignoring invalid LogCaptureCategories entry '%s'."), *Entry);
+                }
+            }
+        }
+
+        // 0 disables the on-disk history.
+        int32 ConfiguredHistoryCapacity = 0;
+        if (GConfig->GetInt(UEMCPServer::ConfigSection, UEMCPServer::ConfigCompileHistoryCapacityKey, ConfiguredHistoryCapacity, GEditorPerProjectIni)
+            && ConfiguredHistoryCapacity >= 0)
+        {
+            CompileHistoryCapacity = ConfiguredHistoryCapacity;
+        }
     }
 
-    LiveCodingManager = MakeUnique<FUEMCPServerLiveCodingManager>();
+    LiveCodingManager = MakeUnique<FUEMCPServerLiveCodingManager>(CaptureSettings, CompileHistoryCapacity);
     LiveCodingManager->Initialize();
 
     if (StartMcpServer())
     {
         UE_LOG(LogUEMCPServer, Display, TEXT("UEMCPServer MCP server listening on http://%s:%u/mcp"),
-            McpBindAddress.IsEmpty() ? TEXT("0.0.0.0") : *McpBindAddress,
-            McpServerPort);
+            McpSettings.BindAddress.IsEmpty() ? TEXT("0.0.0.0") : *McpSettings.BindAddress,
+            McpSettings.Port);
     }
     else
     {
         UE_LOG(LogUEMCPServer, Error, TEXT("Failed to start UEMCPServer MCP server on %s:%u."),
-            McpBindAddress.IsEmpty() ? TEXT("0.0.0.0") : *McpBindAddress,
-            McpServerPort);
+            McpSettings.BindAddress.IsEmpty() ? TEXT("0.0.0.0") : *McpSettings.BindAddress,
+            McpSettings.Port);
     }
 
     FUEMCPServerEditorModeCommands::Register();
@@ -102,7 +192,7 @@ bool FUEMCPServerModule::StartMcpServer()
         return true;
     }
 
-    McpServer = MakeUnique<FUEMCPServerMcpServer>(*LiveCodingManager, McpServerPort, McpBindAddress);
+    McpServer = MakeUnique<FUEMCPServerMcpServer>(*LiveCodingManager, McpSettings);
     if (!McpServer->Start())
     {
         McpServer.Reset();
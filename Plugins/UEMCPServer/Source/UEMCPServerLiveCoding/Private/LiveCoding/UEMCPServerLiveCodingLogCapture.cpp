@@ -2,45 +2,180 @@
 
 #include "Logging/LogVerbosity.h"
 #include "Misc/DateTime.h"
+#include "String/Find.h"
+#include "UObject/NameTypes.h"
 
-FUEMCPServerLiveCodingLogCapture::FUEMCPServerLiveCodingLogCapture() = default;
+FUEMCPServerLogCaptureSettings FUEMCPServerLogCaptureSettings::MakeDefault()
+{
+	FUEMCPServerLogCaptureSettings Settings;
+	Settings.AddCategory(TEXTVIEW("*LiveCoding*"));
+	return Settings;
+}
+
+bool FUEMCPServerLogCaptureSettings::AddCategory(FStringView Entry)
+{
+	Entry = Entry.TrimStartAndEnd();
+
+	ELogVerbosity::Type MaxVerbosity = ELogVerbosity::All;
+	int32 SeparatorIndex = INDEX_NONE;
+	if (Entry.FindChar(TEXT(':'), SeparatorIndex))
+	{
+		MaxVerbosity = ParseLogVerbosityFromString(FString(Entry.RightChop(SeparatorIndex + 1).TrimStartAndEnd()));
+		if (MaxVerbosity == ELogVerbosity::NoLogging)
+		{
+			return false;
+		}
+		Entry = Entry.Left(SeparatorIndex).TrimEnd();
+	}
+
+	if (Entry.IsEmpty())
+	{
+		return false;
+	}
+
+	const bool bIsNamePattern = Entry.Len() > 2 && Entry.StartsWith(TEXT('*')) && Entry.EndsWith(TEXT('*'));
+	const FStringView Name = bIsNamePattern ? Entry.Mid(1, Entry.Len() - 2) : Entry;
+
+	// Only "*Text*" is supported; any other wildcard would silently match nothing.
+	int32 WildcardIndex = INDEX_NONE;
+	if (Name.FindChar(TEXT('*'), WildcardIndex))
+	{
+		return false;
+	}
+
+	FUEMCPServerLogCaptureCategory& Added = Categories.AddDefaulted_GetRef();
+	Added.MaxVerbosity = MaxVerbosity;
+	if (bIsNamePattern)
+	{
+		Added.NameContains = FString(Name);
+	}
+	else
+	{
+		Added.Category = FName(Name);
+	}
+	return true;
+}
+
+FUEMCPServerLiveCodingLogCapture::FUEMCPServerLiveCodingLogCapture(const FUEMCPServerLogCaptureSettings& Settings)
+	: bIsCapturing(false)
+	, CaptureGeneration(0)
+	, Categories(Settings.Categories)
+{
+	bHasNamePatterns = Categories.ContainsByPredicate([](const FUEMCPServerLogCaptureCategory& Entry)
+	{
+		return !Entry.NameContains.IsEmpty();
+	});
+}
 
 void FUEMCPServerLiveCodingLogCapture::StartCapture()
 {
-	FScopeLock CaptureLock(&CaptureMutex);
-	CapturedEntries.Reset();
-	bIsCapturing = true;
+	CapturedLog.Reset();
+	CapturedDiagnostics.Reset();
+
+	// Generation 0 is reserved for "between captures".
+	uint32 Generation = CaptureGeneration.Load() + 1;
+	Generation = Generation == 0 ? 1 : Generation;
+	AcceptedGeneration = Generation;
+	CaptureGeneration.Store(Generation);
+	bIsCapturing.Store(true);
 }
 
-TArray<FUEMCPServerLogEntry> FUEMCPServerLiveCodingLogCapture::StopCapture()
+FUEMCPServerLiveCodingLogBuffer FUEMCPServerLiveCodingLogCapture::StopCapture(FUEMCPServerCompileDiagnostics& OutDiagnostics)
 {
-	FScopeLock CaptureLock(&CaptureMutex);
-	bIsCapturing = false;
-	return MoveTemp(CapturedEntries);
+	bIsCapturing.Store(false);
+
+	// Lines already queued belong to this compile; anything a logging thread queues after this is dropped.
+	FUEMCPServerLogEntry Entry;
+	while (TakeQueuedLine(Entry))
+	{
+		UndeliveredEntries.Add(MoveTemp(Entry));
+	}
+	AcceptedGeneration = 0;
+
+	OutDiagnostics = MoveTemp(CapturedDiagnostics);
+	CapturedDiagnostics.Reset();
+	return MoveTemp(CapturedLog);
 }
 
-void FUEMCPServerLiveCodingLogCapture::Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category)
+int32 FUEMCPServerLiveCodingLogCapture::DrainLiveEntries(TArray<FUEMCPServerLogEntry>& OutEntries, int32 MaxEntries)
 {
-	if (Category.IsNone())
+	const int32 NumUndelivered = FMath::Min(MaxEntries, UndeliveredEntries.Num());
+	for (int32 Index = 0; Index < NumUndelivered; ++Index)
 	{
-		return;
+		OutEntries.Add(MoveTemp(UndeliveredEntries[Index]));
 	}
+	UndeliveredEntries.RemoveAt(0, NumUndelivered, EAllowShrinking::No);
 
-	const FString CategoryString = Category.ToString();
-	if (!CategoryString.Contains(TEXT("LiveCoding")))
+	int32 NumDrained = NumUndelivered;
+	FUEMCPServerLogEntry Entry;
+	while (NumDrained < MaxEntries && TakeQueuedLine(Entry))
 	{
-		return;
+		OutEntries.Add(MoveTemp(Entry));
+		++NumDrained;
+	}
+	return NumDrained;
+}
+
+bool FUEMCPServerLiveCodingLogCapture::TakeQueuedLine(FUEMCPServerLogEntry& OutEntry)
+{
+	FQueuedLine Line;
+	while (QueuedLines.Dequeue(Line))
+	{
+		if (Line.Generation != AcceptedGeneration || AcceptedGeneration == 0)
+		{
+			continue;
+		}
+
+		// Numbered in queue order, so sequences increase even when several threads log at once.
+		OutEntry = MoveTemp(Line.Entry);
+		OutEntry.Sequence = ++LastSequence;
+		CapturedLog.Add(OutEntry.Sequence, OutEntry.Category, OutEntry.Verbosity, OutEntry.Timestamp, OutEntry.Message);
+		CapturedDiagnostics.AddLine(OutEntry.Sequence, OutEntry.Message);
+		return true;
+	}
+	return false;
+}
+
+bool FUEMCPServerLiveCodingLogCapture::PassesFilter(const FName& Category, ELogVerbosity::Type Verbosity) const
+{
+	const ELogVerbosity::Type Level = static_cast<ELogVerbosity::Type>(Verbosity & ELogVerbosity::VerbosityMask);
+	for (const FUEMCPServerLogCaptureCategory& Allowed : Categories)
+	{
+		if (Allowed.NameContains.IsEmpty() && Allowed.Category == Category)
+		{
+			return Level <= Allowed.MaxVerbosity;
+		}
 	}
 
-	FScopeLock CaptureLockInstance(&CaptureMutex);
-	if (!bIsCapturing)
+	if (bHasNamePatterns)
+	{
+		// Copied to the stack; no allocation per line.
+		const FNameBuilder CategoryName(Category);
+		for (const FUEMCPServerLogCaptureCategory& Allowed : Categories)
+		{
+			if (!Allowed.NameContains.IsEmpty()
+				&& UE::String::FindFirst(CategoryName.ToView(), Allowed.NameContains, ESearchCase::IgnoreCase) != INDEX_NONE)
+			{
+				return Level <= Allowed.MaxVerbosity;
+			}
+		}
+	}
+	return false;
+}
+
+void FUEMCPServerLiveCodingLogCapture::Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category)
+{
+	if (!bIsCapturing.Load(EMemoryOrder::Relaxed) || !PassesFilter(Category, Verbosity))
 	{
 		return;
 	}
 
-	FUEMCPServerLogEntry& NewEntry = CapturedEntries.AddDefaulted_GetRef();
-	NewEntry.Category = CategoryString;
-	NewEntry.Message = FString(V);
-	NewEntry.Verbosity = FString(::ToString(Verbosity));
-	NewEntry.Timestamp = FDateTime::UtcNow();
+	// No lock: the line is copied and handed to the consumer, which numbers and records it.
+	FQueuedLine Line;
+	Line.Generation = CaptureGeneration.Load();
+	Line.Entry.Message = V;
+	Line.Entry.Category = Category;
+	Line.Entry.Verbosity = static_cast<ELogVerbosity::Type>(Verbosity & ELogVerbosity::VerbosityMask);
+	Line.Entry.Timestamp = FDateTime::UtcNow();
+	QueuedLines.Enqueue(MoveTemp(Line));
 }
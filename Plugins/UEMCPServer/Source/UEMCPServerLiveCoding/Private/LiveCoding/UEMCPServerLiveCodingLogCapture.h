@@ -1,29 +1,115 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "UEMCPServerCompileDiagnostics.h"
+#include "UEMCPServerLiveCodingLogBuffer.h"
 #include "UEMCPServerLiveCodingTypes.h"
 
-#include "HAL/CriticalSection.h"
-#include "Misc/ScopeLock.h"
+#include "Containers/Queue.h"
+#include "Logging/LogVerbosity.h"
 #include "Misc/OutputDevice.h"
+#include "Templates/Atomic.h"
+
+/** A log category, or every category whose name contains some text, the capture keeps, and the most verbose level it keeps. */
+struct FUEMCPServerLogCaptureCategory
+{
+	FName Category;
+
+	/** Set instead of Category for "*Text*" entries; matched case-insensitively against the category name. */
+	FString NameContains;
+
+	ELogVerbosity::Type MaxVerbosity = ELogVerbosity::All;
+};
+
+/**
+ * Which log lines a compile capture keeps, read by the owning module from the LogCaptureCategories array of the
+ * UEMCPServerSettings config section. Entries are "Category" for one category or "*Text*" for every category whose
+ * name contains Text, optionally followed by ":Verbosity". Exact names are matched by FName; "*Text*" entries cost a
+ * name lookup per line, but only while a compile is being captured.
+ */
+struct FUEMCPServerLogCaptureSettings
+{
+	TArray<FUEMCPServerLogCaptureCategory> Categories;
+
+	/** "*LiveCoding*" at every verbosity: the Live Coding module, console, server and any other LiveCoding category. */
+	static FUEMCPServerLogCaptureSettings MakeDefault();
+
+	/** Adds "Category" or "*Text*", optionally with ":Verbosity"; returns false if the entry cannot be parsed. */
+	bool AddCategory(FStringView Entry);
+};
 
 /**
- * Captures Live Coding logs while a compile is in-flight.
+ * Captures Live Coding logs while a compile is in-flight. Logging threads only copy a kept line into a lock-free
+ * MPSC queue; the one consumer, the game thread, numbers the lines in queue order and builds the compile's log and
+ * diagnostics as it drains them.
  */
 class FUEMCPServerLiveCodingLogCapture : public FOutputDevice
 {
 public:
-	FUEMCPServerLiveCodingLogCapture();
+	explicit FUEMCPServerLiveCodingLogCapture(const FUEMCPServerLogCaptureSettings& Settings = FUEMCPServerLogCaptureSettings::MakeDefault());
 
+	/** Starts a new capture; lines still queued from an earlier one are dropped. Consumer thread only. */
 	void StartCapture();
-	TArray<FUEMCPServerLogEntry> StopCapture();
+
+	/**
+	 * Ends the capture and hands over its log and the diagnostics parsed from it. Lines it had to take off the queue
+	 * are still returned by the next DrainLiveEntries. Consumer thread only.
+	 */
+	FUEMCPServerLiveCodingLogBuffer StopCapture(FUEMCPServerCompileDiagnostics& OutDiagnostics);
+
+	/** Moves up to MaxEntries lines captured since the last call into OutEntries. Consumer thread only. */
+	int32 DrainLiveEntries(TArray<FUEMCPServerLogEntry>& OutEntries, int32 MaxEntries);
 
 	//~ Begin FOutputDevice Interface
 	virtual void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override;
 	//~ End FOutputDevice Interface
 
 private:
-	FCriticalSection CaptureMutex;
-	bool bIsCapturing = false;
-	TArray<FUEMCPServerLogEntry> CapturedEntries;
+	/** A kept line on its way from a logging thread to the consumer. */
+	struct FQueuedLine
+	{
+		/** The capture it was logged during; lines from an ended capture are dropped. */
+		uint32 Generation = 0;
+		FUEMCPServerLogEntry Entry;
+	};
+
+	/**
+	 * True if lines of Category at Verbosity are kept; an exact entry wins over a "*Text*" one. Lock-free; the filter
+	 * never changes after construction.
+	 */
+	bool PassesFilter(const FName& Category, ELogVerbosity::Type Verbosity) const;
+
+	/** Dequeues the next line of the running capture, numbers it and records it in the log and diagnostics. */
+	bool TakeQueuedLine(FUEMCPServerLogEntry& OutEntry);
+
+	/** Checked before anything else in Serialize so every line logged while idle costs one relaxed load. */
+	TAtomic<bool> bIsCapturing;
+
+	/** Stamped on every queued line; bumped by StartCapture. */
+	TAtomic<uint32> CaptureGeneration;
+
+	/** A handful of entries; comparing FNames linearly is cheaper than hashing them. */
+	TArray<FUEMCPServerLogCaptureCategory> Categories;
+
+	/** Whether any entry is a "*Text*" one, so exact-only filters never look the category name up. */
+	bool bHasNamePatterns = false;
+
+	/** Logging threads produce, the game thread consumes. */
+	TQueue<FQueuedLine, EQueueMode::Mpsc> QueuedLines;
+
+	// Everything below belongs to the consumer thread.
+
+	/** Generation whose lines are accepted; 0 between captures. */
+	uint32 AcceptedGeneration = 0;
+
+	FUEMCPServerLiveCodingLogBuffer CapturedLog;
+
+	/** Filled line by line as lines are taken in, so a finished compile has its diagnostics ready. */
+	FUEMCPServerCompileDiagnostics CapturedDiagnostics;
+
+	/** Lines StopCapture took off the queue that have not been handed to DrainLiveEntries yet. */
+	TArray<FUEMCPServerLogEntry> UndeliveredEntries;
+
+	/** Last sequence handed out; never reset, so sequences keep increasing across captures. */
+	int64 LastSequence = 0;
 };
@@ -3,17 +3,67 @@
 #include "UEMCPServerLiveCodingLogCapture.h"
 #include "UEMCPServerLog.h"
 
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "ILiveCodingModule.h"
 #include "Logging/LogMacros.h"
 #include "Misc/OutputDeviceRedirector.h"
+#include "Misc/Paths.h"
 #include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
 
-FUEMCPServerLiveCodingManager::FUEMCPServerLiveCodingManager()
-	: LastCompileTimestamp(FDateTime(0))
-	, LastCompileResult(ELiveCodingCompileResult::NotStarted)
-	, bHasCompileResult(false)
+namespace UEMCPServer::LiveCoding
+{
+	/** Lines per OnCompileLog broadcast; small enough that the first error reaches clients without waiting for more. */
+	static constexpr int32 LiveLogBatchSize = 32;
+
+	static constexpr const TCHAR* HistoryFileName = TEXT("CompileHistory.bin");
+
+	/** How often a running compile is polled; the game thread stays free in between. */
+	static constexpr float CompilePollIntervalSeconds = 0.1f;
+
+	/**
+	 * How long a requested compile may take to show up as compiling, or to apply its patch, before it is reported as
+	 * failed to start. Generous because the first compile of a session may have to launch the Live Coding console.
+	 */
+	static constexpr double CompileStartTimeoutSeconds = 30.0;
+
+	/** How long Shutdown waits for queued history appends, each of which may retry a locked file, before moving on. */
+	static constexpr double ShutdownHistoryWaitSeconds = 3.0;
+
+	static constexpr int32 DefaultBenchmarkLines = 10000;
+
+	/** With and without rounds alternate and the fastest of each counts, so noise from other devices mostly cancels. */
+	static constexpr int32 BenchmarkRounds = 3;
+}
+
+namespace
+{
+	DEFINE_LOG_CATEGORY_STATIC(LogUEMCPServerBenchmark, Log, All);
+
+	/** Average cost of one UE_LOG on a category the capture does not keep, including every registered device. */
+	double MeasureNanosecondsPerLog(int32 Iterations)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		for (int32 Index = 0; Index < Iterations; ++Index)
+		{
+			UE_LOG(LogUEMCPServerBenchmark, Log, TEXT("UEMCPServer log capture benchmark line %d"), Index);
+		}
+		// With a dedicated log thread the devices would otherwise see the lines after the clock stops.
+		GLog->Flush();
+		return FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) * 1.0e6 / Iterations;
+	}
+}
+
+FUEMCPServerLiveCodingManager::FUEMCPServerLiveCodingManager(const FUEMCPServerLogCaptureSettings& InCaptureSettings, int32 InHistoryCapacity)
+	: CaptureSettings(InCaptureSettings)
+	, LastSnapshot(MakeShared<FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe>())
 	, bCompileInProgress(false)
+	, CompileStartTime(FDateTime(0))
+	, HistoryCapacity(InHistoryCapacity)
+	, HistoryQueue(MakeShared<FUEMCPServerSerialQueue, ESPMode::ThreadSafe>())
+	, PendingHistoryWrites(MakeShared<TAtomic<int32>, ESPMode::ThreadSafe>(0))
 {
 }
 
@@ -26,27 +76,71 @@ void FUEMCPServerLiveCodingManager::Initialize()
 {
 	if (!LogCapture.IsValid())
 	{
-		LogCapture = MakeUnique<FUEMCPServerLiveCodingLogCapture>();
+		LogCapture = MakeUnique<FUEMCPServerLiveCodingLogCapture>(CaptureSettings);
 		if (GLog)
 		{
 			GLog->AddOutputDevice(LogCapture.Get());
 		}
 	}
 
+	if (!CaptureBenchmarkCommand)
+	{
+		CaptureBenchmarkCommand = IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("UEMCPServer.BenchmarkLogCapture"),
+			TEXT("Measures what the registered Live Coding log capture device adds to each UE_LOG of an unrelated category. Optional argument: number of lines per round (default 10000)."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FUEMCPServerLiveCodingManager::RunCaptureBenchmark),
+			ECVF_Default);
+	}
+
+	if (!LiveLogTickerHandle.IsValid())
 	{
-		FScopeLock LogLock(&LogMutex);
-		LastCompileLogEntries.Reset();
-		LastCompileTimestamp = FDateTime(0);
-		LastCompileResult = ELiveCodingCompileResult::NotStarted;
-		bHasCompileResult = false;
-		LastErrorMessage.Reset();
+		LiveLogTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+			FTickerDelegate::CreateRaw(this, &FUEMCPServerLiveCodingManager::TickLiveLog));
 	}
 
+	if (!History.IsValid() && HistoryCapacity > 0)
+	{
+		const FString HistoryPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("UEMCPServer"), UEMCPServer::LiveCoding::HistoryFileName);
+		History = MakeShared<FUEMCPServerCompileHistory, ESPMode::ThreadSafe>(HistoryPath, HistoryCapacity);
+		History->Open();
+	}
+
+	PublishSnapshot(MakeShared<FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe>());
 	bCompileInProgress.Store(false);
 }
 
 void FUEMCPServerLiveCodingManager::Shutdown()
 {
+	if (CompilePhase != ECompilePhase::Idle)
+	{
+		FinishRunningCompile(ELiveCodingCompileResult::Cancelled, TEXT("The editor shut down before the Live Coding compile finished."));
+	}
+
+	// Queued appends run code from this module; give them a bounded chance to finish before it can be unloaded
+	// rather than holding up editor shutdown behind a file another process keeps locked.
+	const double WaitDeadline = FPlatformTime::Seconds() + UEMCPServer::LiveCoding::ShutdownHistoryWaitSeconds;
+	while (PendingHistoryWrites->Load() > 0 && FPlatformTime::Seconds() < WaitDeadline)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+
+	if (const int32 Abandoned = PendingHistoryWrites->Load())
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Shut down with %d compile history write(s) still pending; they may be lost."), Abandoned);
+	}
+
+	if (CaptureBenchmarkCommand)
+	{
+		IConsoleManager::Get().UnregisterConsoleObject(CaptureBenchmarkCommand);
+		CaptureBenchmarkCommand = nullptr;
+	}
+
+	if (LiveLogTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(LiveLogTickerHandle);
+		LiveLogTickerHandle.Reset();
+	}
+
 	if (LogCapture.IsValid())
 	{
 		if (GLog)
@@ -57,7 +151,7 @@ void FUEMCPServerLiveCodingManager::Shutdown()
 	}
 }
 
-bool FUEMCPServerLiveCodingManager::TryBeginCompile(FString& OutErrorMessage)
+bool FUEMCPServerLiveCodingManager::TryBeginCompile(const FString& TriggerSource, FString& OutErrorMessage)
 {
 	bool bExpected = false;
 	if (!bCompileInProgress.CompareExchange(bExpected, true))
@@ -72,12 +166,16 @@ bool FUEMCPServerLiveCodingManager::TryBeginCompile(FString& OutErrorMessage)
 		return false;
 	}
 
-	{
-		FScopeLock LogLock(&LogMutex);
-		LastCompileTimestamp = FDateTime::UtcNow();
-		LastCompileResult = ELiveCodingCompileResult::InProgress;
-		LastErrorMessage.Reset();
-	}
+	CompileTriggerSource = TriggerSource;
+	CompileStartTime = FDateTime::UtcNow();
+
+	// The running compile keeps showing the previous log until its own is published.
+	TSharedRef<FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe>(*GetLastCompileSnapshot());
+	Snapshot->Timestamp = FDateTime::UtcNow();
+	Snapshot->Result = ELiveCodingCompileResult::InProgress;
+	Snapshot->bCompileInProgress = true;
+	Snapshot->ErrorMessage.Reset();
+	PublishSnapshot(Snapshot);
 
 	UE_LOG(LogUEMCPServer, Display, TEXT("Live Coding compile request queued."));
 
@@ -121,30 +219,195 @@ void FUEMCPServerLiveCodingManager::ExecuteCompileOnGameThread()
 	UE_LOG(LogUEMCPServer, Display, TEXT("Live Coding compile started via HTTP endpoint."));
 
 	LogCapture->StartCapture();
-	const bool bCompileRequestAccepted = LiveCodingModule->Compile(ELiveCodingCompileFlags::WaitForCompletion, &CompileResult);
-	TArray<FUEMCPServerLogEntry> CapturedEntries = LogCapture->StopCapture();
+	bPatchApplied = false;
+	PatchCompleteHandle = LiveCodingModule->GetOnPatchCompleteDelegate().AddRaw(this, &FUEMCPServerLiveCodingManager::HandlePatchComplete);
+	CompilePhase = ECompilePhase::Starting;
+	CompilePhaseStartSeconds = FPlatformTime::Seconds();
+
+	// Not waiting keeps the editor, and the HTTP listener it ticks, responsive for the whole compile.
+	if (!LiveCodingModule->Compile(ELiveCodingCompileFlags::None, &CompileResult))
+	{
+		FinishRunningCompile(ELiveCodingCompileResult::Failure, TEXT("Live Coding compile request was rejected."));
+		return;
+	}
 
-	if (!bCompileRequestAccepted)
+	if (CompileResult != ELiveCodingCompileResult::InProgress)
 	{
-		FinalizeCompileWithError(TEXT("Live Coding compile request was rejected."), ELiveCodingCompileResult::Failure);
+		FinishRunningCompile(CompileResult);
 		return;
 	}
 
-	FinalizeCompile(MoveTemp(CapturedEntries), CompileResult, FString());
+	// Usually the compile is already running by now, which saves waiting for the first poll to notice.
+	if (LiveCodingModule->IsCompiling())
+	{
+		CompilePhase = ECompilePhase::Compiling;
+	}
+
+	CompileTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+		FTickerDelegate::CreateRaw(this, &FUEMCPServerLiveCodingManager::TickCompile),
+		UEMCPServer::LiveCoding::CompilePollIntervalSeconds);
 }
 
-void FUEMCPServerLiveCodingManager::GetLastCompileSnapshot(TArray<FUEMCPServerLogEntry>& OutEntries, FDateTime& OutTimestamp, ELiveCodingCompileResult& OutResult, bool& bOutHasResult, FString& OutErrorMessage, bool& bOutIsInProgress) const
+bool FUEMCPServerLiveCodingManager::TickCompile(float DeltaTime)
 {
-	FScopeLock LogLock(&LogMutex);
-	OutEntries = LastCompileLogEntries;
-	OutTimestamp = LastCompileTimestamp;
-	OutResult = LastCompileResult;
-	bOutHasResult = bHasCompileResult;
-	OutErrorMessage = LastErrorMessage;
-	bOutIsInProgress = bCompileInProgress.Load();
+	ILiveCodingModule* LiveCodingModule = FModuleManager::GetModulePtr<ILiveCodingModule>(LIVE_CODING_MODULE_NAME);
+	const bool bIsCompiling = LiveCodingModule && LiveCodingModule->IsCompiling();
+
+	if (CompilePhase == ECompilePhase::Starting)
+	{
+		if (bIsCompiling)
+		{
+			CompilePhase = ECompilePhase::Compiling;
+			return true;
+		}
+
+		// Only Live Coding itself can say the compile ran: it was seen compiling, or its patch landed first.
+		if (!bPatchApplied)
+		{
+			if (!LiveCodingModule)
+			{
+				CompileTickerHandle.Reset();
+				FinishRunningCompile(ELiveCodingCompileResult::Failure, TEXT("The Live Coding module was unloaded before the compile started."));
+				return false;
+			}
+
+			if (FPlatformTime::Seconds() - CompilePhaseStartSeconds < UEMCPServer::LiveCoding::CompileStartTimeoutSeconds)
+			{
+				return true;
+			}
+
+			CompileTickerHandle.Reset();
+			FinishRunningCompile(ELiveCodingCompileResult::Failure, FString::Printf(
+				TEXT("Live Coding did not start the compile within %.0f seconds."), UEMCPServer::LiveCoding::CompileStartTimeoutSeconds));
+			return false;
+		}
+	}
+	else if (bIsCompiling)
+	{
+		return true;
+	}
+
+	// Returning false removes this ticker; forget the handle so FinishRunningCompile does not remove it again.
+	CompileTickerHandle.Reset();
+	FinishRunningCompile();
+	return false;
 }
 
+void FUEMCPServerLiveCodingManager::HandlePatchComplete()
+{
+	bPatchApplied = true;
+}
 
+void FUEMCPServerLiveCodingManager::FinishRunningCompile(TOptional<ELiveCodingCompileResult> Result, const FString& ErrorMessage)
+{
+	if (CompileTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(CompileTickerHandle);
+		CompileTickerHandle.Reset();
+	}
+
+	if (PatchCompleteHandle.IsValid())
+	{
+		if (ILiveCodingModule* LiveCodingModule = FModuleManager::GetModulePtr<ILiveCodingModule>(LIVE_CODING_MODULE_NAME))
+		{
+			LiveCodingModule->GetOnPatchCompleteDelegate().Remove(PatchCompleteHandle);
+		}
+		PatchCompleteHandle.Reset();
+	}
+	CompilePhase = ECompilePhase::Idle;
+
+	FUEMCPServerCompileDiagnostics Diagnostics;
+	FUEMCPServerLiveCodingLogBuffer CapturedLog = LogCapture->StopCapture(Diagnostics);
+
+	if (!Result.IsSet())
+	{
+		// ILiveCodingModule hands out a result only from a waiting Compile(); a non-waiting one reports success
+		// through the patch delegate alone, so a failure is known by the compiler errors it produced.
+		Result = bPatchApplied ? ELiveCodingCompileResult::Success
+			: Diagnostics.NumErrors() > 0 ? ELiveCodingCompileResult::Failure
+			: ELiveCodingCompileResult::NoChanges;
+	}
+
+	if (!ErrorMessage.IsEmpty())
+	{
+		UE_LOG(LogUEMCPServer, Error, TEXT("%s"), *ErrorMessage);
+	}
+	FinalizeCompile(MoveTemp(CapturedLog), MoveTemp(Diagnostics), Result.GetValue(), ErrorMessage);
+}
+
+FUEMCPServerCompileSnapshotRef FUEMCPServerLiveCodingManager::GetLastCompileSnapshot() const
+{
+	FReadScopeLock ReadGuard(SnapshotLock);
+	return LastSnapshot;
+}
+
+void FUEMCPServerLiveCodingManager::PublishSnapshot(FUEMCPServerCompileSnapshotRef Snapshot)
+{
+	{
+		FWriteScopeLock WriteGuard(SnapshotLock);
+		Swap(LastSnapshot, Snapshot);
+	}
+	// The previous snapshot, and possibly its log, is released here, outside the lock.
+}
+
+void FUEMCPServerLiveCodingManager::ArchiveCompile(const FUEMCPServerCompileSnapshotRef& Snapshot)
+{
+	if (!History.IsValid())
+	{
+		return;
+	}
+
+	FUEMCPServerCompileSummary Summary;
+	Summary.StartTime = CompileStartTime.GetTicks() > 0 ? CompileStartTime : Snapshot->Timestamp;
+	Summary.FinishTime = Snapshot->Timestamp;
+	Summary.Result = Snapshot->Result;
+	Summary.TriggerSource = CompileTriggerSource;
+	Summary.NumErrors = Snapshot->Diagnostics->NumErrors();
+	Summary.NumWarnings = Snapshot->Diagnostics->NumWarnings();
+
+	PendingHistoryWrites->IncrementExchange();
+	HistoryQueue->Enqueue([PendingWrites = PendingHistoryWrites, HistoryRef = History.ToSharedRef(), Snapshot, Summary = MoveTemp(Summary)]() mutable
+	{
+		HistoryRef->Append(MoveTemp(Summary), Snapshot->ErrorMessage, *Snapshot->Log);
+		PendingWrites->DecrementExchange();
+	});
+}
+
+void FUEMCPServerLiveCodingManager::RunCaptureBenchmark(const TArray<FString>& Args)
+{
+	if (!LogCapture.IsValid() || !GLog)
+	{
+		UE_LOG(LogUEMCPServer, Warning, TEXT("Live coding log capture is not available."));
+		return;
+	}
+
+	if (CompilePhase != ECompilePhase::Idle)
+	{
+		// Unregistering the device mid-compile would lose lines.
+		UE_LOG(LogUEMCPServer, Warning, TEXT("The log capture benchmark cannot run while a compile is in progress."));
+		return;
+	}
+
+	int32 Iterations = UEMCPServer::LiveCoding::DefaultBenchmarkLines;
+	if (Args.Num() > 0)
+	{
+		LexFromString(Iterations, *Args[0]);
+	}
+	Iterations = FMath::Max(Iterations, 1);
+
+	double WithoutNs = MAX_dbl;
+	double WithNs = MAX_dbl;
+	for (int32 Round = 0; Round < UEMCPServer::LiveCoding::BenchmarkRounds; ++Round)
+	{
+		GLog->RemoveOutputDevice(LogCapture.Get());
+		WithoutNs = FMath::Min(WithoutNs, MeasureNanosecondsPerLog(Iterations));
+		GLog->AddOutputDevice(LogCapture.Get());
+		WithNs = FMath::Min(WithNs, MeasureNanosecondsPerLog(Iterations));
+	}
+
+	UE_LOG(LogUEMCPServer, Display, TEXT("UE_LOG cost over %d lines of an uncaptured category: %.1f ns/line without the capture device, %.1f ns/line with it registered; the device adds %.1f ns/line."),
+		Iterations, WithoutNs, WithNs, WithNs - WithoutNs);
+}
 
 bool FUEMCPServerLiveCodingManager::EnsureCaptureAvailable(FString& OutErrorMessage)
 {
@@ -178,16 +441,41 @@ bool FUEMCPServerLiveCodingManager::EnsureLiveCodingAvailable(FString& OutErrorM
 	return true;
 }
 
-void FUEMCPServerLiveCodingManager::FinalizeCompile(TArray<FUEMCPServerLogEntry>&& CapturedEntries, ELiveCodingCompileResult Result, const FString& ErrorMessage)
+void FUEMCPServerLiveCodingManager::PublishLiveLog()
 {
+	if (!LogCapture.IsValid())
+	{
+		return;
+	}
+
+	TArray<FUEMCPServerLogEntry> Batch;
+	while (LogCapture->DrainLiveEntries(Batch, UEMCPServer::LiveCoding::LiveLogBatchSize) > 0)
 	{
-		FScopeLock LogLock(&LogMutex);
-		LastCompileLogEntries = MoveTemp(CapturedEntries);
-		LastCompileTimestamp = FDateTime::UtcNow();
-		LastCompileResult = Result;
-		LastErrorMessage = ErrorMessage;
-		bHasCompileResult = true;
+		CompileLogEvent.Broadcast(Batch);
+		Batch.Reset();
 	}
+}
+
+bool FUEMCPServerLiveCodingManager::TickLiveLog(float DeltaTime)
+{
+	PublishLiveLog();
+	return true;
+}
+
+void FUEMCPServerLiveCodingManager::FinalizeCompile(FUEMCPServerLiveCodingLogBuffer&& CapturedLog, FUEMCPServerCompileDiagnostics&& Diagnostics, ELiveCodingCompileResult Result, const FString& ErrorMessage)
+{
+	// Lines still queued belong to this compile; deliver them before anyone hears it finished.
+	PublishLiveLog();
+
+	TSharedRef<FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FUEMCPServerCompileSnapshot, ESPMode::ThreadSafe>();
+	Snapshot->Log = MakeShared<FUEMCPServerLiveCodingLogBuffer, ESPMode::ThreadSafe>(MoveTemp(CapturedLog));
+	Snapshot->Diagnostics = MakeShared<FUEMCPServerCompileDiagnostics, ESPMode::ThreadSafe>(MoveTemp(Diagnostics));
+	Snapshot->Timestamp = FDateTime::UtcNow();
+	Snapshot->Result = Result;
+	Snapshot->bHasResult = true;
+	Snapshot->ErrorMessage = ErrorMessage;
+	PublishSnapshot(Snapshot);
+	ArchiveCompile(Snapshot);
 
 	bCompileInProgress.Store(false);
 
@@ -208,14 +496,16 @@ void FUEMCPServerLiveCodingManager::FinalizeCompile(TArray<FUEMCPServerLogEntry>
 	default:
 		break;
 	}
+
+	CompileFinishedEvent.Broadcast(Result);
 }
 
 void FUEMCPServerLiveCodingManager::FinalizeCompileWithError(const FString& ErrorMessage, ELiveCodingCompileResult Result)
 {
-	TArray<FUEMCPServerLogEntry> EmptyEntries;
+	FUEMCPServerLiveCodingLogBuffer EmptyLog;
 	if (!ErrorMessage.IsEmpty())
 	{
 		UE_LOG(LogUEMCPServer, Error, TEXT("%s"), *ErrorMessage);
 	}
-	FinalizeCompile(MoveTemp(EmptyEntries), Result, ErrorMessage);
+	FinalizeCompile(MoveTemp(EmptyLog), FUEMCPServerCompileDiagnostics(), Result, ErrorMessage);
 }
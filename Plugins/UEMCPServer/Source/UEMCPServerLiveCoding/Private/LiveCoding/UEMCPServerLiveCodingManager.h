@@ -4,48 +4,117 @@
 #include "UEMCPServerLiveCodingTypes.h"
 
 #include "IUEMCPServerLiveCodingProvider.h"
+#include "UEMCPServerLiveCodingLogCapture.h"
 
-#include "HAL/CriticalSection.h"
+#include "Containers/Ticker.h"
+#include "Mcp/UEMCPServerSerialQueue.h"
+#include "Misc/ScopeRWLock.h"
 #include "Templates/Atomic.h"
 
+class IConsoleObject;
 enum class ELiveCodingCompileResult : uint8;
 
-class FUEMCPServerLiveCodingLogCapture;
-
 /**
  * Owns the Live Coding compile flow and maintains the latest log snapshot.
  */
 class FUEMCPServerLiveCodingManager : public IUEMCPServerLiveCodingProvider
 {
 public:
-	FUEMCPServerLiveCodingManager();
+	explicit FUEMCPServerLiveCodingManager(const FUEMCPServerLogCaptureSettings& InCaptureSettings = FUEMCPServerLogCaptureSettings::MakeDefault(), int32 InHistoryCapacity = 50);
 	~FUEMCPServerLiveCodingManager();
 
 	void Initialize();
 	void Shutdown();
 
-	/** Attempts to begin a compile; returns false if one is already running or setup failed. */
-	virtual bool TryBeginCompile(FString& OutErrorMessage) override;
+	/** Attempts to begin a compile; returns false if one is already running or setup failed. TriggerSource is archived with it. */
+	virtual bool TryBeginCompile(const FString& TriggerSource, FString& OutErrorMessage) override;
 
-	/** Executes the Live Coding compile synchronously. Must be called on the game thread. */
+	/** Starts the Live Coding compile without waiting for it; a ticker finalizes it. Must be called on the game thread. */
 	virtual void ExecuteCompileOnGameThread() override;
 
-	/** Retrieves the latest compile snapshot and status information. */
-	virtual void GetLastCompileSnapshot(TArray<FUEMCPServerLogEntry>& OutEntries, FDateTime& OutTimestamp, ELiveCodingCompileResult& OutResult, bool& bOutHasResult, FString& OutErrorMessage, bool& bOutIsInProgress) const override;
+	/** The latest published compile snapshot; safe to call from any thread and to hold for as long as needed. */
+	virtual FUEMCPServerCompileSnapshotRef GetLastCompileSnapshot() const override;
+
+	/** Archive of recent compiles, or null when the history is disabled. */
+	virtual const FUEMCPServerCompileHistory* GetCompileHistory() const override { return History.Get(); }
+
+	/** Event raised whenever a compile finishes, successfully or not. */
+	virtual FUEMCPServerOnCompileFinished& OnCompileFinished() override { return CompileFinishedEvent; }
+
+	/** Event raised with captured log lines as they arrive; every batch precedes the compile's finish event. */
+	virtual FUEMCPServerOnCompileLog& OnCompileLog() override { return CompileLogEvent; }
 
 private:
 	bool EnsureCaptureAvailable(FString& OutErrorMessage);
 	bool EnsureLiveCodingAvailable(FString& OutErrorMessage, class ILiveCodingModule*& OutModule) const;
-	void FinalizeCompile(TArray<FUEMCPServerLogEntry>&& CapturedEntries, ELiveCodingCompileResult Result, const FString& ErrorMessage);
+	void FinalizeCompile(FUEMCPServerLiveCodingLogBuffer&& CapturedLog, FUEMCPServerCompileDiagnostics&& Diagnostics, ELiveCodingCompileResult Result, const FString& ErrorMessage);
 	void FinalizeCompileWithError(const FString& ErrorMessage, ELiveCodingCompileResult Result);
 
+	/** Polls the running compile and finalizes it once Live Coding reports it idle. */
+	bool TickCompile(float DeltaTime);
+	void HandlePatchComplete();
+
+	/**
+	 * Stops the capture, stops watching Live Coding and finalizes with Result or, when unset, with the result the
+	 * patch delegate and the compiler diagnostics give.
+	 */
+	void FinishRunningCompile(TOptional<ELiveCodingCompileResult> Result = TOptional<ELiveCodingCompileResult>(), const FString& ErrorMessage = FString());
+
+	/** Broadcasts every line the capture has queued since the last call. Game thread only. */
+	void PublishLiveLog();
+	bool TickLiveLog(float DeltaTime);
+
+	/** Replaces the published snapshot; the new one must be fully built, it is never touched again. */
+	void PublishSnapshot(FUEMCPServerCompileSnapshotRef Snapshot);
+
+	/** Archives a finished compile on a worker thread; the snapshot is immutable, so it is read there without copying. */
+	void ArchiveCompile(const FUEMCPServerCompileSnapshotRef& Snapshot);
+
+	/** UEMCPServer.BenchmarkLogCapture: what the registered capture device adds to every UE_LOG. */
+	void RunCaptureBenchmark(const TArray<FString>& Args);
+
 private:
+	FUEMCPServerLogCaptureSettings CaptureSettings;
 	TUniquePtr<FUEMCPServerLiveCodingLogCapture> LogCapture;
-	mutable FCriticalSection LogMutex;
-	TArray<FUEMCPServerLogEntry> LastCompileLogEntries;
-	FDateTime LastCompileTimestamp;
-	ELiveCodingCompileResult LastCompileResult;
-	bool bHasCompileResult;
+
+	/** Guards only the pointer swap: readers take a reference and leave, nothing is copied under it. */
+	mutable FRWLock SnapshotLock;
+	FUEMCPServerCompileSnapshotRef LastSnapshot;
+
+	/** Claimed by TryBeginCompile so two compiles can never start at once. */
 	TAtomic<bool> bCompileInProgress;
-	FString LastErrorMessage;
+
+	/** Recorded by TryBeginCompile for the history; game thread only. */
+	FString CompileTriggerSource;
+	FDateTime CompileStartTime;
+
+	int32 HistoryCapacity;
+	TSharedPtr<FUEMCPServerCompileHistory, ESPMode::ThreadSafe> History;
+
+	/**
+	 * Keeps history appends in compile order; Shutdown waits a bounded time for the ones still queued. The counter is
+	 * shared with the queued appends so one that outlives the wait never touches this manager.
+	 */
+	TSharedRef<FUEMCPServerSerialQueue, ESPMode::ThreadSafe> HistoryQueue;
+	TSharedRef<TAtomic<int32>, ESPMode::ThreadSafe> PendingHistoryWrites;
+
+	/** Where the compile started by ExecuteCompileOnGameThread is; game thread only. */
+	enum class ECompilePhase : uint8
+	{
+		Idle,
+		/** Requested, but Live Coding has not reported it as compiling yet. */
+		Starting,
+		Compiling,
+	};
+	ECompilePhase CompilePhase = ECompilePhase::Idle;
+	double CompilePhaseStartSeconds = 0.0;
+	bool bPatchApplied = false;
+	FDelegateHandle PatchCompleteHandle;
+	FTSTicker::FDelegateHandle CompileTickerHandle;
+
+	FUEMCPServerOnCompileFinished CompileFinishedEvent;
+	FUEMCPServerOnCompileLog CompileLogEvent;
+	FTSTicker::FDelegateHandle LiveLogTickerHandle;
+
+	IConsoleObject* CaptureBenchmarkCommand = nullptr;
 };
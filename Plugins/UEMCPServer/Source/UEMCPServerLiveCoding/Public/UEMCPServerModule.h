@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Mcp/UEMCPServerMcpSettings.h"
 #include "Modules/ModuleManager.h"
 #include "Templates/UniquePtr.h"
 
@@ -28,6 +29,5 @@ private:
 private:
 	TUniquePtr<FUEMCPServerMcpServer> McpServer;
 	TUniquePtr<FUEMCPServerLiveCodingManager> LiveCodingManager;
-	uint32 McpServerPort = 8133;
-	FString McpBindAddress;
+	FUEMCPServerMcpServerSettings McpSettings;
 };